@@ -1,20 +1,32 @@
 #include "Connection.hpp"
+#include "../utils/ShipUtils.hpp"
+#include "eventloop/NetworkEventLoop.hpp"
 #include "pipe/FramedPipe.hpp"
+#include <algorithm>
 
 namespace Ship {
-  thread_local ByteBuffer* connectionWriteBuffer = new ByteBufferImpl(MAX_PACKET_SIZE);
-
   Connection::Connection(BytePacketPipe* byte_packet_pipe, PacketHandler* main_packet_handler, size_t reader_buffer_length, size_t writer_buffer_length,
     ReadWriteCloser* read_write_closer, EventLoop* event_loop)
     : bytePacketPipe(byte_packet_pipe), mainPacketHandler(main_packet_handler), readerBuffer(new ByteBufferImpl(reader_buffer_length)),
-      writerBuffer(new ByteBufferImpl(writer_buffer_length)), readWriteCloser(read_write_closer), eventLoop(event_loop) {
+      writerBuffer(new ByteBufferImpl(writer_buffer_length)), packetBuffer(new ByteBufferImpl(writer_buffer_length)), readWriteCloser(read_write_closer), eventLoop(event_loop),
+      lastActivityMillis(ShipUtils::GetCurrentMillis()) {
   }
 
   Connection::~Connection() {
+    for (ByteBytePipe* pipe : pipeline) {
+      RetirePipe(pipe);
+    }
+
     onClose();
+    // Zero-copy sends may still pin a segment of the writer buffer, closing first lets the socket take it out.
+    if (readWriteCloser) {
+      readWriteCloser->Close();
+    }
+
     delete bytePacketPipe;
     delete readerBuffer;
     delete writerBuffer;
+    delete packetBuffer;
     delete mainPacketHandler;
     for (const auto& item : packetHandlers) {
       delete item;
@@ -25,6 +37,7 @@ namespace Ship {
   void Connection::SetBytePacketPipe(BytePacketPipe* newBytePacketPipe) {
     delete bytePacketPipe;
     bytePacketPipe = newBytePacketPipe;
+    bytePacketPipe->SetForwardFilter(rawForwardPeerHandle != 0 ? &handledOrdinals : nullptr);
   }
 
   BytePacketPipe* Connection::GetBytePacketPipe() {
@@ -46,6 +59,8 @@ namespace Ship {
         pipeline.insert(++afterIterator, byte_byte_pipe);
         return;
       }
+
+      ++afterIterator;
     }
   }
 
@@ -56,26 +71,36 @@ namespace Ship {
         pipeline.insert(beforeIterator, byte_byte_pipe);
         return;
       }
+
+      ++beforeIterator;
     }
   }
 
   void Connection::RemoveByteBytePipe(uint32_t byte_byte_pipe_ordinal) {
-    pipeline.remove_if([byte_byte_pipe_ordinal](ByteBytePipe*& pipe) {
-      return byte_byte_pipe_ordinal == pipe->GetOrdinal();
+    pipeline.remove_if([this, byte_byte_pipe_ordinal](ByteBytePipe*& pipe) {
+      if (byte_byte_pipe_ordinal != pipe->GetOrdinal()) {
+        return false;
+      }
+
+      RetirePipe(pipe);
+      return true;
     });
   }
 
   void Connection::ReplaceMainPacketHandler(PacketHandler* packet_handler) {
     delete mainPacketHandler;
     mainPacketHandler = packet_handler;
+    handledOrdinalsStale = true;
   }
 
   void Connection::AppendPacketHandler(PacketHandler* byteBytePipe) {
     packetHandlers.push_back(byteBytePipe);
+    handledOrdinalsStale = true;
   }
 
   void Connection::PrependPacketHandler(PacketHandler* byteBytePipe) {
     packetHandlers.push_front(byteBytePipe);
+    handledOrdinalsStale = true;
   }
 
   void Connection::AppendPacketHandler(PacketHandler* byteBytePipe, uint32_t afterOrdinal) {
@@ -83,8 +108,11 @@ namespace Ship {
     while (afterIterator != packetHandlers.end()) {
       if ((*afterIterator)->GetOrdinal() == afterOrdinal) {
         packetHandlers.insert(++afterIterator, byteBytePipe);
+        handledOrdinalsStale = true;
         return;
       }
+
+      ++afterIterator;
     }
   }
 
@@ -93,18 +121,23 @@ namespace Ship {
     while (beforeIterator != packetHandlers.end()) {
       if ((*beforeIterator)->GetOrdinal() == beforeOrdinal) {
         packetHandlers.insert(beforeIterator, byteBytePipe);
+        handledOrdinalsStale = true;
         return;
       }
+
+      ++beforeIterator;
     }
   }
 
   void Connection::RemovePacketHandler(uint32_t byteByteOrdinal) {
-    pipeline.remove_if([byteByteOrdinal](ByteBytePipe*& pipe) {
-      return byteByteOrdinal == pipe->GetOrdinal();
+    packetHandlers.remove_if([byteByteOrdinal](PacketHandler*& handler) {
+      return byteByteOrdinal == handler->GetOrdinal();
     });
+    handledOrdinalsStale = true;
   }
 
-  void Connection::HandleNewBytes(uint8_t* page, size_t page_size) {
+  size_t Connection::HandleNewBytes(uint8_t* page, size_t page_size, size_t max_packets) {
+    lastActivityMillis = ShipUtils::GetCurrentMillis();
     ByteBuffer* currentBuffer = readerBuffer;
     currentBuffer->WriteBytes(page, page_size);
 
@@ -113,66 +146,204 @@ namespace Ship {
       currentBuffer = byteBytePipe->GetReaderBuffer();
     }
 
-    Errorable<PacketHolder> packet = bytePacketPipe->Read(currentBuffer);
-    if (packet.IsSuccess()) {
-      Errorable<bool> wasHandled = mainPacketHandler->Handle(mainPacketHandler, this, packet.GetValue());
-      if (!wasHandled.IsSuccess()) {
-        // TODO: Log error
-        readWriteCloser->Close();
-        return;
-      }
+    return HandleBufferedPackets(max_packets);
+  }
 
-      if (!wasHandled.GetValue()) {
-        for (const auto& item : packetHandlers) {
-          wasHandled = item->Handle(item, this, packet.GetValue());
-          if (!wasHandled.IsSuccess()) {
-            // TODO: Log error
-            readWriteCloser->Close();
-          }
-
-          if (wasHandled.GetValue()) {
-            break;
-          }
-        }
+  size_t Connection::HandleBufferedPackets(size_t max_packets) {
+    ByteBuffer* currentBuffer = pipeline.empty() ? readerBuffer : pipeline.back()->GetReaderBuffer();
+
+    // A peer closed since the last batch turns forwarding off before any frame is filtered for it.
+    if (rawForwardPeerHandle != 0 && ResolveRawForwardPeer() && handledOrdinalsStale) {
+      RefreshHandledOrdinals();
+    }
+
+    size_t packets = 0;
+    // A handler starting a passthrough takes the remaining bytes over undecoded, see ForwardUnreadBytes.
+    while ((max_packets == 0 || packets < max_packets) && !passthrough) {
+      if (HandleFrame(currentBuffer) == 0) {
+        break;
       }
+
+      ++packets;
+    }
+
+    FlushRawForwardPeer();
+    return packets;
+  }
+
+  size_t Connection::HandleFrame(ByteBuffer* buffer) {
+    Errorable<PacketHolder> packet = bytePacketPipe->Read(buffer);
+    if (packet.IsSuccess()) {
+      return HandlePacket(packet.GetValue()) ? 1 : 0;
+    } else if (packet.GetTypeOrdinal() == ForwardedFrameErrorable::TYPE_ORDINAL) {
+      return ForwardFrame(buffer, (uint32_t) packet.GetErrorCode()) ? 1 : 0;
     } else if (packet.GetTypeOrdinal() != IncompleteFrameErrorable::TYPE_ORDINAL) {
       // TODO: Log error.
       readWriteCloser->Close();
-      return;
     }
+
+    return 0;
+  }
+
+  bool Connection::HandlePacket(const PacketHolder& packet) {
+    Errorable<bool> wasHandled = mainPacketHandler->Handle(mainPacketHandler, this, packet);
+    if (!wasHandled.IsSuccess()) {
+      // TODO: Log error
+      readWriteCloser->Close();
+      return false;
+    }
+
+    if (!wasHandled.GetValue()) {
+      for (const auto& item : packetHandlers) {
+        wasHandled = item->Handle(item, this, packet);
+        if (!wasHandled.IsSuccess()) {
+          // TODO: Log error
+          readWriteCloser->Close();
+          return false;
+        }
+
+        if (wasHandled.GetValue()) {
+          break;
+        }
+      }
+    }
+
+    return true;
   }
 
   void Connection::Write(const Packet& packet) {
-    connectionWriteBuffer->ResetReaderIndex();
-    connectionWriteBuffer->ResetWriterIndex();
-    Errorable<bool> shouldWriteErrorable = bytePacketPipe->Write(connectionWriteBuffer, packet);
+    Errorable<bool> shouldWriteErrorable = bytePacketPipe->Write(packetBuffer, packet);
 
     if (!shouldWriteErrorable.IsSuccess()) {
       // TODO: Log error.
+      packetBuffer->Release();
       readWriteCloser->Close();
       return;
     }
 
     if (shouldWriteErrorable.GetValue()) {
-      ByteBuffer* buffer = connectionWriteBuffer;
+      WriteSerialized(packetBuffer);
+    }
+
+    packetBuffer->Release();
+  }
+
+  void Connection::WriteSerialized(ByteBuffer* buffer) {
+    if (offloadSequence && offloadSequence->IsBusy()) {
+      size_t readableBytes = buffer->GetReadableBytes();
+      // Owned by the completion, so it goes away with the sequence if the connection is destroyed before the completion ran.
+      std::shared_ptr<ByteBuffer> pendingBuffer = std::make_shared<ByteBufferImpl>(buffer->GetSingleCapacity());
+      pendingBuffer->WriteBytes(buffer, readableBytes);
+      offloadSequence->Then([this, pendingBuffer]() {
+        WriteThroughPipeline(pendingBuffer.get(), pipeline.rbegin());
+        Flush();
+      });
+      return;
+    }
+
+    WriteThroughPipeline(buffer, pipeline.rbegin());
+  }
+
+  void Connection::WriteThroughPipeline(ByteBuffer* buffer, std::list<ByteBytePipe*>::reverse_iterator from) {
+    Offloader* offloader = eventLoop->GetOffloader();
+    for (auto byteBytePipeIterator = from; byteBytePipeIterator != pipeline.rend(); ++byteBytePipeIterator) {
+      ByteBytePipe* pipe = *byteBytePipeIterator;
+      if (offloader && pipe->ShouldOffload(buffer)) {
+        OffloadPipeWrite(offloader, pipe, buffer);
+        return;
+      }
+
+      Errorable<size_t> pipeShouldWriteErrorable = pipe->Write(buffer);
+      if (!pipeShouldWriteErrorable.IsSuccess()) {
+        // TODO: Log error.
+        readWriteCloser->Close();
+        return;
+      }
+
+      if (!pipeShouldWriteErrorable.GetValue()) {
+        return;
+      }
+
+      buffer = pipe->GetWriterBuffer();
+    }
+
+    WriteDirect(buffer);
+  }
+
+  void Connection::RetirePipe(ByteBytePipe* pipe) {
+    auto pipeGuard = pipeGuards.find(pipe);
+    if (pipeGuard == pipeGuards.end()) {
+      delete pipe;
+      return;
+    }
+
+    // A worker may still be inside WriteOffloaded, the output of its jobs is dropped and the pipe is deleted back on the loop.
+    EventLoop* loop = eventLoop;
+    pipeGuard->second->Close([loop, pipe]() {
+      loop->Post([pipe]() {
+        delete pipe;
+      });
+    });
+    pipeGuards.erase(pipeGuard);
+  }
+
+  void Connection::OffloadPipeWrite(Offloader* offloader, ByteBytePipe* pipe, ByteBuffer* buffer) {
+    size_t readableBytes = buffer->GetReadableBytes();
+    std::shared_ptr<ByteBuffer> input = std::make_shared<ByteBufferImpl>(buffer->GetSingleCapacity());
+    input->WriteBytes(buffer, readableBytes);
+    std::shared_ptr<ByteBuffer> output = std::make_shared<ByteBufferImpl>(pipe->GetWriterBuffer()->GetSingleCapacity());
+    std::shared_ptr<Errorable<size_t>> result = std::make_shared<Errorable<size_t>>(SuccessErrorable<size_t>(0));
+    std::shared_ptr<OffloadGuard>& pipeGuard = pipeGuards[pipe];
+    if (!pipeGuard) {
+      pipeGuard = std::make_shared<OffloadGuard>();
+    }
+
+    offloader->Offload(
+      GetOffloadSequence(), readableBytes,
+      [pipe, pipeGuard = pipeGuard, input, output, result]() {
+        if (!pipeGuard->Enter()) {
+          return;
+        }
+
+        *result = pipe->WriteOffloaded(input.get(), output.get());
+        pipeGuard->Leave();
+      },
+      [this, pipe, pipeGuard = pipeGuard, output, result]() {
+        if (pipeGuard->IsClosed()) {
+          return;
+        }
 
-      for (auto byteBytePipeIterator = pipeline.rbegin(); byteBytePipeIterator != pipeline.rend(); ++byteBytePipeIterator) {
-        ByteBytePipe* pipe = *byteBytePipeIterator;
-        Errorable<size_t> pipeShouldWriteErrorable = pipe->Write(buffer);
-        if (!pipeShouldWriteErrorable.IsSuccess()) {
+        if (!result->IsSuccess()) {
           // TODO: Log error.
           readWriteCloser->Close();
           return;
         }
 
-        if (!pipeShouldWriteErrorable.GetValue()) {
+        auto pipeIterator = std::find(pipeline.rbegin(), pipeline.rend(), pipe);
+        if (!result->GetValue() || pipeIterator == pipeline.rend()) {
           return;
         }
 
-        buffer = pipe->GetWriterBuffer();
-      }
+        WriteThroughPipeline(output.get(), ++pipeIterator);
+        Flush();
+      });
+  }
+
+  std::shared_ptr<OffloadSequence>& Connection::GetOffloadSequence() {
+    if (!offloadSequence) {
+      offloadSequence = std::make_shared<OffloadSequence>();
+    }
 
-      WriteDirect(buffer);
+    return offloadSequence;
+  }
+
+  void Connection::Offload(size_t weight, std::function<void()> work, std::function<void()> completion) {
+    Offloader* offloader = eventLoop->GetOffloader();
+    if (offloader) {
+      offloader->Offload(GetOffloadSequence(), weight, std::move(work), std::move(completion));
+    } else {
+      work();
+      completion();
     }
   }
 
@@ -189,15 +360,161 @@ namespace Ship {
     return readWriteCloser;
   }
 
+  ReadWriteCloser* Connection::ReleaseReadWriteCloser() {
+    ReadWriteCloser* released = readWriteCloser;
+    readWriteCloser = nullptr;
+    return released;
+  }
+
   EventLoop* Connection::GetEventLoop() {
     return eventLoop;
   }
 
-  void Connection::Flush() {
-    readWriteCloser->Write(writerBuffer);
+  Errorable<ssize_t> Connection::Flush() {
+    lastActivityMillis = ShipUtils::GetCurrentMillis();
+    return readWriteCloser->Write(writerBuffer);
+  }
+
+  size_t Connection::GetPendingWriteBytes() const {
+    return writerBuffer->GetReadableBytes();
+  }
+
+  void Connection::ReleaseIdleBuffers(uint64_t current_millis, uint64_t idle_millis) {
+    if (current_millis - lastActivityMillis < idle_millis) {
+      return;
+    }
+
+    readerBuffer->ReleaseIfDrained();
+    writerBuffer->ReleaseIfDrained();
+    for (const auto& byteBytePipe : pipeline) {
+      byteBytePipe->GetReaderBuffer()->ReleaseIfDrained();
+      byteBytePipe->GetWriterBuffer()->ReleaseIfDrained();
+    }
+  }
+
+  size_t Connection::GetResidentBufferBytes() const {
+    size_t residentBytes = readerBuffer->GetResidentBytes() + writerBuffer->GetResidentBytes();
+    for (const auto& byteBytePipe : pipeline) {
+      residentBytes += byteBytePipe->GetReaderBuffer()->GetResidentBytes() + byteBytePipe->GetWriterBuffer()->GetResidentBytes();
+    }
+
+    return residentBytes;
   }
 
   void Connection::SetOnClose(const std::function<void()>& on_close) {
     onClose = on_close;
   }
+
+  void Connection::SetHandle(uint64_t new_handle) {
+    handle = new_handle;
+  }
+
+  uint64_t Connection::GetHandle() const {
+    return handle;
+  }
+
+  void Connection::SetPassthrough(Passthrough* new_passthrough) {
+    passthrough = new_passthrough;
+  }
+
+  Passthrough* Connection::GetPassthrough() const {
+    return passthrough;
+  }
+
+  void Connection::ForwardUnreadBytes(Connection* peer) {
+    peer->WriteDirect(readerBuffer);
+  }
+
+  bool Connection::HasPipelineInput() const {
+    return std::any_of(pipeline.begin(), pipeline.end(), [](ByteBytePipe* pipe) {
+      return pipe->GetReaderBuffer()->GetReadableBytes() != 0;
+    });
+  }
+
+  Errorable<bool> Connection::SetRawForwardPeer(Connection* peer, const IdRemapTable* remap_table) {
+    if (peer && (peer->eventLoop != eventLoop || ((NetworkEventLoop*) eventLoop)->FindConnection(peer->handle) != peer)) {
+      return ForeignForwardPeerErrorable(false);
+    }
+
+    FlushRawForwardPeer();
+    rawForwardPeerHandle = peer ? peer->handle : 0;
+    rawForwardRemapTable = remap_table && !remap_table->IsIdentity() ? remap_table : nullptr;
+    handledOrdinalsStale = true;
+    bytePacketPipe->SetForwardFilter(peer ? &handledOrdinals : nullptr);
+    return SuccessErrorable<bool>(true);
+  }
+
+  Connection* Connection::GetRawForwardPeer() const {
+    return rawForwardPeerHandle != 0 ? ((NetworkEventLoop*) eventLoop)->FindConnection(rawForwardPeerHandle) : nullptr;
+  }
+
+  Connection* Connection::ResolveRawForwardPeer() {
+    Connection* peer = GetRawForwardPeer();
+    if (!peer && rawForwardPeerHandle != 0) {
+      // The peer got closed, the remaining frames are decoded and handled here again.
+      rawForwardPeerHandle = 0;
+      rawForwardRemapTable = nullptr;
+      rawForwardFlushPending = false;
+      bytePacketPipe->SetForwardFilter(nullptr);
+    }
+
+    return peer;
+  }
+
+  void Connection::RefreshHandledOrdinals() {
+    handledOrdinals.Clear();
+    mainPacketHandler->CollectCallbackOrdinals(handledOrdinals);
+    for (const auto& item : packetHandlers) {
+      item->CollectCallbackOrdinals(handledOrdinals);
+    }
+
+    handledOrdinalsStale = false;
+  }
+
+  bool Connection::ForwardFrame(ByteBuffer* buffer, uint32_t frame_size) {
+    Connection* peer = ResolveRawForwardPeer();
+    if (!peer) {
+      // The peer got closed by a handler earlier in this batch, the frame is decoded and handled like any other.
+      // Only FramedBytePacketPipe leaves frames undecoded, so the pipe is one.
+      Errorable<PacketHolder> packet = ((FramedBytePacketPipe*) bytePacketPipe)->ReadPacket(buffer, frame_size);
+      if (!packet.IsSuccess()) {
+        // TODO: Log error.
+        readWriteCloser->Close();
+        return false;
+      }
+
+      return HandlePacket(packet.GetValue());
+    }
+
+    // The frame is re-prefixed and sent through the peer pipeline, so compression and encryption still apply on the other side.
+    ByteBuffer* forwardBuffer = peer->packetBuffer;
+    if (rawForwardRemapTable) {
+      if (!rawForwardRemapTable->RewriteFrame(buffer, frame_size, forwardBuffer).IsSuccess()) {
+        // TODO: Log error.
+        forwardBuffer->Release();
+        readWriteCloser->Close();
+        return false;
+      }
+    } else {
+      forwardBuffer->WriteVarInt(frame_size);
+      forwardBuffer->WriteBytes(buffer, frame_size);
+    }
+
+    peer->WriteSerialized(forwardBuffer);
+    forwardBuffer->Release();
+    rawForwardFlushPending = true;
+    return true;
+  }
+
+  void Connection::FlushRawForwardPeer() {
+    if (!rawForwardFlushPending) {
+      return;
+    }
+
+    rawForwardFlushPending = false;
+    Connection* peer = ResolveRawForwardPeer();
+    if (peer) {
+      peer->Flush();
+    }
+  }
 }
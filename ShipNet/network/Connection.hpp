@@ -2,12 +2,19 @@
 
 #include "../protocol/handler/PacketHandler.hpp"
 #include "../protocol/packet/Packet.hpp"
+#include "../protocol/registry/IdRemapTable.hpp"
 #include "../utils/thread/EventLoop.hpp"
+#include "../utils/thread/Offloader.hpp"
 #include "pipe/Pipe.hpp"
 #include "readwritecloser/ReadWriteCloser.hpp"
 #include <list>
+#include <memory>
+#include <unordered_map>
 
 namespace Ship {
+  class Passthrough;
+
+  CreateInvalidArgumentErrorable(ForeignForwardPeerErrorable, bool, "Raw forward peer is not a connection of this event loop");
 
   class Connection {
    private:
@@ -17,9 +24,33 @@ namespace Ship {
     std::list<PacketHandler*> packetHandlers;
     ByteBuffer* readerBuffer;
     ByteBuffer* writerBuffer;
+    ByteBuffer* packetBuffer;
     ReadWriteCloser* readWriteCloser;
     EventLoop* eventLoop;
     std::function<void()> onClose;
+    std::shared_ptr<OffloadSequence> offloadSequence;
+    // Closed when their pipe is removed or the connection goes away, so the caller may delete the pipe afterwards.
+    std::unordered_map<ByteBytePipe*, std::shared_ptr<OffloadGuard>> pipeGuards;
+    uint64_t lastActivityMillis;
+    Passthrough* passthrough = nullptr;
+    // Slab handle of the peer, resolved per frame so a closed peer turns forwarding off instead of being written to.
+    uint64_t rawForwardPeerHandle = 0;
+    bool rawForwardFlushPending = false;
+    const IdRemapTable* rawForwardRemapTable = nullptr;
+    OrdinalBitmap handledOrdinals;
+    bool handledOrdinalsStale = true;
+    uint64_t handle = 0;
+
+    void WriteThroughPipeline(ByteBuffer* buffer, std::list<ByteBytePipe*>::reverse_iterator from);
+    void OffloadPipeWrite(Offloader* offloader, ByteBytePipe* pipe, ByteBuffer* buffer);
+    void RetirePipe(ByteBytePipe* pipe);
+    std::shared_ptr<OffloadSequence>& GetOffloadSequence();
+    void RefreshHandledOrdinals();
+    size_t HandleFrame(ByteBuffer* buffer);
+    bool HandlePacket(const PacketHolder& packet);
+    Connection* ResolveRawForwardPeer();
+    bool ForwardFrame(ByteBuffer* buffer, uint32_t frame_size);
+    void FlushRawForwardPeer();
 
    public:
     Connection(BytePacketPipe* byte_packet_pipe, PacketHandler* main_packet_handler, size_t reader_buffer_length, size_t writer_buffer_length,
@@ -30,6 +61,7 @@ namespace Ship {
     void SetBytePacketPipe(BytePacketPipe* newBytePacketPipe);
     BytePacketPipe* GetBytePacketPipe();
 
+    // Pipes are owned by the connection, a removed one is deleted once no offloaded write of it runs anymore.
     void AppendByteBytePipe(ByteBytePipe* byte_byte_pipe);
     void PrependByteBytePipe(ByteBytePipe* byte_byte_pipe);
     void AppendByteBytePipe(ByteBytePipe* byte_byte_pipe, uint32_t after_ordinal);
@@ -43,18 +75,49 @@ namespace Ship {
     void PrependPacketHandler(PacketHandler* packet_handler, uint32_t before_ordinal);
     void RemovePacketHandler(uint32_t packet_handler_ordinal);
 
-    void HandleNewBytes(uint8_t* page, size_t page_size);
+    // Both decode and handle every complete frame, at most max_packets of them unless it is zero, and return how many they
+    // handled. Frames left over by the limit stay buffered for the next HandleBufferedPackets.
+    size_t HandleNewBytes(uint8_t* page, size_t page_size, size_t max_packets = 0);
+    size_t HandleBufferedPackets(size_t max_packets = 0);
 
     void Write(const Packet& packet);
     void WriteAndFlush(const Packet& packet);
 
+    void WriteSerialized(ByteBuffer* buffer);
     void WriteDirect(ByteBuffer* buffer);
 
+    void Offload(size_t weight, std::function<void()> work, std::function<void()> completion);
+
     ReadWriteCloser* GetReadWriteCloser();
+    // Hands the read write closer over to the caller, the connection neither closes nor deletes it afterwards.
+    ReadWriteCloser* ReleaseReadWriteCloser();
     EventLoop* GetEventLoop();
 
-    void Flush();
+    Errorable<ssize_t> Flush();
+    [[nodiscard]] size_t GetPendingWriteBytes() const;
+
+    void ReleaseIdleBuffers(uint64_t current_millis, uint64_t idle_millis);
+    [[nodiscard]] size_t GetResidentBufferBytes() const;
 
     void SetOnClose(const std::function<void()>& on_close);
+
+    // Slab handle assigned by the owning loop, safe to keep in tasks that may run after the connection is gone.
+    void SetHandle(uint64_t new_handle);
+    [[nodiscard]] uint64_t GetHandle() const;
+
+    void SetPassthrough(Passthrough* new_passthrough);
+    [[nodiscard]] Passthrough* GetPassthrough() const;
+    // Bytes pipes already took from the reader buffer are transformed and can't be forwarded, see HasPipelineInput.
+    void ForwardUnreadBytes(Connection* peer);
+    // True while a ByteBytePipe holds input the next stage hasn't consumed, such as the rest of a partial cipher or compression frame.
+    [[nodiscard]] bool HasPipelineInput() const;
+
+    // Frames of packets no registered handler has a callback for are written to the peer undecoded, nullptr disables forwarding.
+    // The peer is kept by its slab handle, forwarding turns itself off once the peer is closed. A remap table translates packet
+    // ids when the peer speaks another protocol version, see VersionedRegistry::GetRemapTable. Frames go straight into the peer
+    // buffers and are flushed once per batch of frames, so a peer that isn't a live connection of this loop is rejected.
+    Errorable<bool> SetRawForwardPeer(Connection* peer, const IdRemapTable* remap_table = nullptr);
+    // nullptr when forwarding is off or the peer got closed. Loop thread only.
+    [[nodiscard]] Connection* GetRawForwardPeer() const;
   };
 }
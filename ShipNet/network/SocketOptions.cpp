@@ -0,0 +1,120 @@
+#include "SocketOptions.hpp"
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+namespace Ship {
+  static void SetOption(int socket_file_descriptor, int level, int option, int value, int& error) {
+    if (setsockopt(socket_file_descriptor, level, option, &value, sizeof(value)) == -1 && error == 0) {
+      error = errno;
+    }
+  }
+
+  static Errorable<int> ToErrorable(int socket_file_descriptor, int error) {
+    if (error != 0) {
+      errno = error;
+      return ErrnoErrorable<int>(socket_file_descriptor);
+    }
+
+    return SuccessErrorable<int>(socket_file_descriptor);
+  }
+
+  SocketOptions SocketOptions::Latency() {
+    SocketOptions options;
+    options.noDelay = true;
+    options.quickAck = true;
+    // Keeps little unsent data in the kernel, so fresh packets are not queued behind stale ones.
+    options.notSentLowWatermark = 16384;
+    options.deferAcceptSeconds = 1;
+    options.busyPollMicros = 50;
+    return options;
+  }
+
+  SocketOptions SocketOptions::Bulk() {
+    SocketOptions options;
+    options.sendBufferSize = 4 * 1024 * 1024;
+    options.receiveBufferSize = 4 * 1024 * 1024;
+    options.deferAcceptSeconds = 1;
+    return options;
+  }
+
+  Errorable<int> SocketOptions::ApplyToListener(int socket_file_descriptor) const {
+    int error = 0;
+    // Buffer sizes have to be known before the handshake to affect window scaling, accepted sockets inherit them.
+    if (sendBufferSize != 0) {
+      SetOption(socket_file_descriptor, SOL_SOCKET, SO_SNDBUF, sendBufferSize, error);
+    }
+
+    if (receiveBufferSize != 0) {
+      SetOption(socket_file_descriptor, SOL_SOCKET, SO_RCVBUF, receiveBufferSize, error);
+    }
+
+#ifdef TCP_DEFER_ACCEPT
+    if (deferAcceptSeconds != 0) {
+      SetOption(socket_file_descriptor, IPPROTO_TCP, TCP_DEFER_ACCEPT, deferAcceptSeconds, error);
+    }
+#endif
+#ifdef TCP_FASTOPEN
+    if (fastOpenQueue != 0) {
+      SetOption(socket_file_descriptor, IPPROTO_TCP, TCP_FASTOPEN, fastOpenQueue, error);
+    }
+#endif
+
+    return ToErrorable(socket_file_descriptor, error);
+  }
+
+  Errorable<int> SocketOptions::ApplyToSocket(int socket_file_descriptor) const {
+    int error = 0;
+    if (noDelay) {
+      SetOption(socket_file_descriptor, IPPROTO_TCP, TCP_NODELAY, 1, error);
+    }
+
+#ifdef TCP_QUICKACK
+    if (quickAck) {
+      SetOption(socket_file_descriptor, IPPROTO_TCP, TCP_QUICKACK, 1, error);
+    }
+#endif
+
+    if (sendBufferSize != 0) {
+      SetOption(socket_file_descriptor, SOL_SOCKET, SO_SNDBUF, sendBufferSize, error);
+    }
+
+    if (receiveBufferSize != 0) {
+      SetOption(socket_file_descriptor, SOL_SOCKET, SO_RCVBUF, receiveBufferSize, error);
+    }
+
+#ifdef TCP_NOTSENT_LOWAT
+    if (notSentLowWatermark != 0) {
+      SetOption(socket_file_descriptor, IPPROTO_TCP, TCP_NOTSENT_LOWAT, notSentLowWatermark, error);
+    }
+#endif
+#ifdef SO_BUSY_POLL
+    if (busyPollMicros != 0) {
+      SetOption(socket_file_descriptor, SOL_SOCKET, SO_BUSY_POLL, busyPollMicros, error);
+    }
+#endif
+#ifdef SO_PREFER_BUSY_POLL
+    if (preferBusyPoll) {
+      SetOption(socket_file_descriptor, SOL_SOCKET, SO_PREFER_BUSY_POLL, 1, error);
+    }
+#endif
+#ifdef SO_BUSY_POLL_BUDGET
+    if (busyPollBudget != 0) {
+      SetOption(socket_file_descriptor, SOL_SOCKET, SO_BUSY_POLL_BUDGET, busyPollBudget, error);
+    }
+#endif
+
+    return ToErrorable(socket_file_descriptor, error);
+  }
+
+  Errorable<int> SocketOptions::ApplyBeforeConnect(int socket_file_descriptor) const {
+    int error = ApplyToSocket(socket_file_descriptor).IsSuccess() ? 0 : errno;
+#ifdef TCP_FASTOPEN_CONNECT
+    if (fastOpenQueue != 0) {
+      SetOption(socket_file_descriptor, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, 1, error);
+    }
+#endif
+
+    return ToErrorable(socket_file_descriptor, error);
+  }
+}
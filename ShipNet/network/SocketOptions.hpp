@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../utils/exception/Errorable.hpp"
+#include <sys/socket.h>
+
+namespace Ship {
+  // Zero leaves the corresponding option at the kernel default, options the platform lacks are skipped.
+  class SocketOptions {
+   public:
+    bool noDelay = false;
+    // Not sticky on Linux, the kernel may fall back to delayed ACKs later in the connection.
+    bool quickAck = false;
+    int sendBufferSize = 0;
+    int receiveBufferSize = 0;
+    int notSentLowWatermark = 0;
+    int deferAcceptSeconds = 0;
+    // Pending TFO request queue of listeners, any non-zero value enables TCP_FASTOPEN_CONNECT on outbound sockets.
+    int fastOpenQueue = 0;
+    int busyPollMicros = 0;
+    // Lets the busy polling of the loop take over from softirq processing while it keeps polling, see EpollEventLoop::SetBusyPoll.
+    bool preferBusyPoll = false;
+    int busyPollBudget = 0;
+    int backlog = SOMAXCONN;
+    // Flushes of at least this many bytes are sent with MSG_ZEROCOPY. Enabled by the event loop per connection, not by ApplyToSocket.
+    size_t zeroCopyThreshold = 0;
+
+    static SocketOptions Latency();
+    static SocketOptions Bulk();
+
+    // All of them try every option and report the first failing one.
+    Errorable<int> ApplyToListener(int socket_file_descriptor) const;
+    Errorable<int> ApplyToSocket(int socket_file_descriptor) const;
+    Errorable<int> ApplyBeforeConnect(int socket_file_descriptor) const;
+  };
+}
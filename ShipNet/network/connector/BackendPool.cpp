@@ -0,0 +1,60 @@
+#ifdef __linux__
+  #include "BackendPool.hpp"
+  #include <utility>
+
+namespace Ship {
+  BackendPool::BackendPool(EpollEventLoop* event_loop, ConnectionInitializer initializer, size_t warm_connections, uint64_t connect_timeout_millis)
+    : eventLoop(event_loop), initializer(std::move(initializer)), warmConnections(warm_connections), connectTimeoutMillis(connect_timeout_millis) {
+  }
+
+  std::string BackendPool::KeyOf(const SocketAddress& address) {
+    return address.GetHostname() + ":" + std::to_string(address.GetPort());
+  }
+
+  BackendTarget& BackendPool::TargetOf(const SocketAddress& address) {
+    return targets.try_emplace(KeyOf(address), BackendTarget {address, {}, 0}).first->second;
+  }
+
+  void BackendPool::AddTarget(const SocketAddress& address) {
+    TargetOf(address);
+    Refill(KeyOf(address));
+  }
+
+  void BackendPool::Refill(const std::string& key) {
+    BackendTarget& target = targets.at(key);
+    while (target.idleHandles.size() + target.connecting < warmConnections) {
+      ++target.connecting;
+      eventLoop->Connect(target.address, connectTimeoutMillis, [this, key](Errorable<Connection*> connection) {
+        BackendTarget& connectedTarget = targets.at(key);
+        --connectedTarget.connecting;
+        // Failed connects are not retried here, the next Acquire refills the pool again.
+        if (connection.IsSuccess()) {
+          connectedTarget.idleHandles.push_back(connection.GetValue()->GetHandle());
+        }
+      }, initializer);
+    }
+  }
+
+  void BackendPool::Acquire(const SocketAddress& address, ConnectCallback callback) {
+    BackendTarget& target = TargetOf(address);
+    Connection* connection = nullptr;
+    while (!connection && !target.idleHandles.empty()) {
+      connection = eventLoop->FindConnection(target.idleHandles.front());
+      target.idleHandles.pop_front();
+    }
+
+    if (connection) {
+      callback(SuccessErrorable<Connection*>(connection));
+    } else {
+      eventLoop->Connect(address, connectTimeoutMillis, std::move(callback), initializer);
+    }
+
+    Refill(KeyOf(address));
+  }
+
+  size_t BackendPool::GetIdleCount(const SocketAddress& address) const {
+    auto target = targets.find(KeyOf(address));
+    return target == targets.end() ? 0 : target->second.idleHandles.size();
+  }
+}
+#endif
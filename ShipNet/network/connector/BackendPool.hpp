@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../eventloop/NetworkEventLoop.hpp"
+#include <deque>
+#include <unordered_map>
+
+namespace Ship {
+#ifdef __linux__
+  class BackendTarget {
+   public:
+    SocketAddress address;
+    // Slab handles, so connections the backend closed while idling are simply skipped.
+    std::deque<uint64_t> idleHandles;
+    size_t connecting = 0;
+  };
+
+  // Keeps pre-connected backend connections per target address, so handing a player over doesn't wait for a TCP handshake.
+  // Every method has to be called on the thread of the loop.
+  class BackendPool {
+   private:
+    EpollEventLoop* eventLoop;
+    ConnectionInitializer initializer;
+    size_t warmConnections;
+    uint64_t connectTimeoutMillis;
+    std::unordered_map<std::string, BackendTarget> targets;
+
+    static std::string KeyOf(const SocketAddress& address);
+    BackendTarget& TargetOf(const SocketAddress& address);
+    void Refill(const std::string& key);
+
+   public:
+    BackendPool(EpollEventLoop* event_loop, ConnectionInitializer initializer, size_t warm_connections, uint64_t connect_timeout_millis);
+
+    void AddTarget(const SocketAddress& address);
+    // Hands out an idle connection right away or falls back to a fresh connect, the pool is refilled in the background.
+    void Acquire(const SocketAddress& address, ConnectCallback callback);
+    [[nodiscard]] size_t GetIdleCount(const SocketAddress& address) const;
+  };
+#endif
+}
@@ -1,7 +1,9 @@
 #include "Connector.hpp"
 #include <arpa/inet.h>
+#include <cerrno>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <unistd.h>
 
 namespace Ship {
   thread_local char* errorBuffer = new char[64];
@@ -15,8 +17,11 @@ namespace Ship {
       return ErrnoErrorable<int>(socketFileDescriptor);
     }
 
-    if (ioctl(socketFileDescriptor, FIONBIO) == -1) {
-      return ErrnoErrorable<int>(socketFileDescriptor);
+    int nonBlocking = 1;
+    if (ioctl(socketFileDescriptor, FIONBIO, &nonBlocking) == -1) {
+      ErrnoErrorable<int> errorable(socketFileDescriptor);
+      close(socketFileDescriptor);
+      return errorable;
     }
 
     sockaddr_in bindAddress {};
@@ -24,8 +29,11 @@ namespace Ship {
     bindAddress.sin_port = htons(port);
     bindAddress.sin_addr.s_addr = inet_addr(bind_address);
 
-    if (connect(socketFileDescriptor, (sockaddr*) &bindAddress, sizeof(sockaddr_in)) == -1) {
-      return ErrnoErrorable<int>(socketFileDescriptor);
+    // The handshake of a non-blocking socket finishes in the background, writes queue up until then.
+    if (connect(socketFileDescriptor, (sockaddr*) &bindAddress, sizeof(sockaddr_in)) == -1 && errno != EINPROGRESS) {
+      ErrnoErrorable<int> errorable(socketFileDescriptor);
+      close(socketFileDescriptor);
+      return errorable;
     }
 
     eventLoop->Accept(socketFileDescriptor);
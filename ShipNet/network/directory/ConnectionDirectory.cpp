@@ -0,0 +1,142 @@
+#include "ConnectionDirectory.hpp"
+#include "../../utils/thread/Epoch.hpp"
+#include <utility>
+
+namespace Ship {
+  ConnectionDirectory::ConnectionDirectory()
+    : uuidShards(new DirectoryShard<UUID>[SHARD_COUNT]), nameShards(new DirectoryShard<std::string>[SHARD_COUNT]) {
+  }
+
+  ConnectionDirectory::~ConnectionDirectory() {
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+      delete uuidShards[i].table.load();
+      delete nameShards[i].table.load();
+    }
+
+    delete[] uuidShards;
+    delete[] nameShards;
+  }
+
+  DirectoryShard<UUID>& ConnectionDirectory::ShardOf(const UUID& uuid) const {
+    // The table inside a shard uses the low bits of the same hash, so the shard is picked by the high ones.
+    return uuidShards[(std::hash<UUID>()(uuid) >> 32) % SHARD_COUNT];
+  }
+
+  DirectoryShard<std::string>& ConnectionDirectory::ShardOf(const std::string& name) const {
+    return nameShards[(std::hash<std::string>()(name) >> 32) % SHARD_COUNT];
+  }
+
+  template<typename K>
+  const ConnectionEntry* ConnectionDirectory::FindIn(const DirectoryShard<K>& shard, const K& key) {
+    const typename DirectoryShard<K>::Table* table = shard.table.load();
+    if (!table) {
+      return nullptr;
+    }
+
+    auto entry = table->find(key);
+    return entry == table->end() ? nullptr : &entry->second;
+  }
+
+  template<typename K>
+  void ConnectionDirectory::Publish(DirectoryShard<K>& shard, const typename DirectoryShard<K>::Table* table) {
+    const typename DirectoryShard<K>::Table* previous = shard.table.exchange(table);
+    if (previous) {
+      Epoch::Retire([previous]() {
+        delete previous;
+      });
+    }
+  }
+
+  bool ConnectionDirectory::Register(Connection* connection, const UUID& uuid, const std::string& name) {
+    DirectoryShard<UUID>& uuidShard = ShardOf(uuid);
+    std::lock_guard<std::mutex> uuidLock(uuidShard.writeMutex);
+    if (FindIn(uuidShard, uuid)) {
+      return false;
+    }
+
+    ConnectionEntry entry {connection->GetHandle(), (NetworkEventLoop*) connection->GetEventLoop(), uuid, name};
+    if (!name.empty()) {
+      // Name shards are always locked after UUID shards, so writers can't deadlock.
+      DirectoryShard<std::string>& nameShard = ShardOf(name);
+      std::lock_guard<std::mutex> nameLock(nameShard.writeMutex);
+      if (FindIn(nameShard, name)) {
+        return false;
+      }
+
+      const auto* names = nameShard.table.load();
+      auto* newNames = names ? new DirectoryShard<std::string>::Table(*names) : new DirectoryShard<std::string>::Table();
+      newNames->emplace(name, entry);
+      Publish(nameShard, newNames);
+    }
+
+    const auto* uuids = uuidShard.table.load();
+    auto* newUUIDs = uuids ? new DirectoryShard<UUID>::Table(*uuids) : new DirectoryShard<UUID>::Table();
+    newUUIDs->emplace(uuid, std::move(entry));
+    Publish(uuidShard, newUUIDs);
+    ++size;
+    return true;
+  }
+
+  bool ConnectionDirectory::Unregister(const UUID& uuid, Connection* connection) {
+    DirectoryShard<UUID>& uuidShard = ShardOf(uuid);
+    std::lock_guard<std::mutex> uuidLock(uuidShard.writeMutex);
+    const ConnectionEntry* entry = FindIn(uuidShard, uuid);
+    if (!entry || entry->handle != connection->GetHandle() || entry->eventLoop != connection->GetEventLoop()) {
+      return false;
+    }
+
+    if (!entry->name.empty()) {
+      DirectoryShard<std::string>& nameShard = ShardOf(entry->name);
+      std::lock_guard<std::mutex> nameLock(nameShard.writeMutex);
+      auto* newNames = new DirectoryShard<std::string>::Table(*nameShard.table.load());
+      newNames->erase(entry->name);
+      Publish(nameShard, newNames);
+    }
+
+    auto* newUUIDs = new DirectoryShard<UUID>::Table(*uuidShard.table.load());
+    newUUIDs->erase(uuid);
+    Publish(uuidShard, newUUIDs);
+    --size;
+    return true;
+  }
+
+  Errorable<ConnectionEntry> ConnectionDirectory::Find(const UUID& uuid) const {
+    Epoch::ReadGuard guard;
+    const ConnectionEntry* entry = FindIn(ShardOf(uuid), uuid);
+    if (!entry) {
+      return UnknownConnectionErrorable(UUID::STRING_SIZE);
+    }
+
+    return SuccessErrorable<ConnectionEntry>(*entry);
+  }
+
+  Errorable<ConnectionEntry> ConnectionDirectory::FindByName(const std::string& name) const {
+    Epoch::ReadGuard guard;
+    const ConnectionEntry* entry = FindIn(ShardOf(name), name);
+    if (!entry) {
+      return UnknownConnectionErrorable(name.size());
+    }
+
+    return SuccessErrorable<ConnectionEntry>(*entry);
+  }
+
+  bool ConnectionDirectory::Post(const UUID& uuid, std::function<void(Connection*)> task) {
+    ProceedErrorable(entry, ConnectionEntry, Find(uuid), false)
+    NetworkEventLoop* eventLoop = entry.eventLoop;
+    uint64_t handle = entry.handle;
+    eventLoop->Post([this, uuid, eventLoop, handle, task = std::move(task)]() {
+      // Handles of closed connections never resolve again, even when their memory or slot got reused.
+      Errorable<ConnectionEntry> current = Find(uuid);
+      Connection* connection = current.IsSuccess() && current.GetValue().handle == handle ? eventLoop->FindConnection(handle) : nullptr;
+      if (connection) {
+        task(connection);
+      }
+    });
+
+    return true;
+  }
+
+  size_t ConnectionDirectory::GetSize() const {
+    return size.load(std::memory_order_relaxed);
+  }
+}
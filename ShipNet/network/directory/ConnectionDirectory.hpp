@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../../protocol/data/uuid/UUID.hpp"
+#include "../Connection.hpp"
+#include "../eventloop/NetworkEventLoop.hpp"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace Ship {
+  // The connection itself is only reachable on its loop, through NetworkEventLoop::FindConnection with the handle.
+  class ConnectionEntry {
+   public:
+    uint64_t handle = 0;
+    NetworkEventLoop* eventLoop = nullptr;
+    UUID uuid;
+    std::string name;
+  };
+
+  CreateInvalidArgumentErrorable(UnknownConnectionErrorable, ConnectionEntry, "No connection is registered for the key, key size");
+
+  template<typename K>
+  class alignas(64) DirectoryShard {
+   public:
+    using Table = std::unordered_map<K, ConnectionEntry>;
+
+    std::mutex writeMutex;
+    std::atomic<const Table*> table {nullptr};
+  };
+
+  // Finds connections by UUID or name from any thread. Lookups take no lock, writers copy the touched shard and the previous
+  // copy is deleted after an Epoch grace period, so every shard stays small enough to be copied on registration.
+  class ConnectionDirectory {
+   private:
+    DirectoryShard<UUID>* uuidShards;
+    DirectoryShard<std::string>* nameShards;
+    std::atomic<size_t> size {0};
+
+    template<typename K>
+    static const ConnectionEntry* FindIn(const DirectoryShard<K>& shard, const K& key);
+    template<typename K>
+    static void Publish(DirectoryShard<K>& shard, const typename DirectoryShard<K>::Table* table);
+
+    DirectoryShard<UUID>& ShardOf(const UUID& uuid) const;
+    DirectoryShard<std::string>& ShardOf(const std::string& name) const;
+
+   public:
+    static constexpr size_t SHARD_COUNT = 1024;
+
+    ConnectionDirectory();
+    ~ConnectionDirectory();
+
+    ConnectionDirectory(const ConnectionDirectory&) = delete;
+    ConnectionDirectory& operator=(const ConnectionDirectory&) = delete;
+
+    // The owning loop and the handle are taken from the connection, so it has to be added to its loop already. An empty name is
+    // not indexed. Fails if the UUID or the name is taken.
+    bool Register(Connection* connection, const UUID& uuid, const std::string& name);
+    // Only removes the entry while it still belongs to the given connection, call it from the connection's close handler.
+    bool Unregister(const UUID& uuid, Connection* connection);
+
+    [[nodiscard]] Errorable<ConnectionEntry> Find(const UUID& uuid) const;
+    [[nodiscard]] Errorable<ConnectionEntry> FindByName(const std::string& name) const;
+
+    // Runs the task on the owning loop, it is skipped if the connection got unregistered or closed before. The directory must outlive the loops.
+    bool Post(const UUID& uuid, std::function<void(Connection*)> task);
+
+    [[nodiscard]] size_t GetSize() const;
+  };
+}
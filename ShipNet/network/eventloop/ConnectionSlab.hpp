@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Ship {
+  class Connection;
+  class UnixReadWriteCloser;
+
+  // Connection slots of one loop addressed by (generation, slot index) handles, a handle of a removed connection never resolves again.
+  class ConnectionSlab {
+   private:
+    class Slot {
+     public:
+      Connection* connection;
+      // The socket the loop created for the connection, the connection itself only knows it as a ReadWriteCloser.
+      UnixReadWriteCloser* readWriteCloser;
+      uint32_t generation;
+      uint32_t denseIndex;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    // Live connections packed together for whole-loop passes, denseSlots maps them back to their slot.
+    std::vector<Connection*> dense;
+    std::vector<uint32_t> denseSlots;
+
+   public:
+    // Never handed out, so they can mark non-connection epoll events.
+    static constexpr uint64_t NONE = 0;
+    static constexpr uint64_t TAGGED = 1ULL << 63;
+    static constexpr uint32_t MAX_GENERATION = 0x7FFFFFFF;
+
+    uint64_t Insert(Connection* connection, UnixReadWriteCloser* read_write_closer = nullptr) {
+      uint32_t index;
+      if (freeSlots.empty()) {
+        index = slots.size();
+        slots.push_back({nullptr, nullptr, 1, 0});
+      } else {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+      }
+
+      Slot& slot = slots[index];
+      slot.connection = connection;
+      slot.readWriteCloser = read_write_closer;
+      slot.denseIndex = dense.size();
+      dense.push_back(connection);
+      denseSlots.push_back(index);
+      return (uint64_t) slot.generation << 32 | index;
+    }
+
+    bool Remove(uint64_t handle) {
+      uint32_t index = handle;
+      if (!Get(handle)) {
+        return false;
+      }
+
+      Slot& slot = slots[index];
+      uint32_t last = dense.size() - 1;
+      dense[slot.denseIndex] = dense[last];
+      denseSlots[slot.denseIndex] = denseSlots[last];
+      slots[denseSlots[last]].denseIndex = slot.denseIndex;
+      dense.pop_back();
+      denseSlots.pop_back();
+
+      slot.connection = nullptr;
+      slot.readWriteCloser = nullptr;
+      // Generations stay within 31 bits and skip zero, so no handle equals NONE or has a TAGGED bit.
+      slot.generation = slot.generation == MAX_GENERATION ? 1 : slot.generation + 1;
+      freeSlots.push_back(index);
+      return true;
+    }
+
+    [[nodiscard]] Connection* Get(uint64_t handle) const {
+      uint32_t index = handle;
+      if (index >= slots.size() || slots[index].generation != (uint32_t) (handle >> 32)) {
+        return nullptr;
+      }
+
+      return slots[index].connection;
+    }
+
+    [[nodiscard]] UnixReadWriteCloser* GetReadWriteCloser(uint64_t handle) const {
+      return Get(handle) ? slots[(uint32_t) handle].readWriteCloser : nullptr;
+    }
+
+    [[nodiscard]] const std::vector<Connection*>& GetConnections() const {
+      return dense;
+    }
+
+    [[nodiscard]] size_t GetSize() const {
+      return dense.size();
+    }
+  };
+}
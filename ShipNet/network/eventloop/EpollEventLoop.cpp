@@ -1,7 +1,14 @@
 #ifdef __linux__
+  #include "../../utils/ShipUtils.hpp"
   #include "NetworkEventLoop.hpp"
+  #include <algorithm>
+  #include <arpa/inet.h>
+  #include <cerrno>
+  #include <chrono>
   #include <fcntl.h>
   #include <sys/epoll.h>
+  #include <sys/eventfd.h>
+  #include <sys/socket.h>
   #include <thread>
   #include <unistd.h>
   #include <utility>
@@ -9,64 +16,534 @@
 namespace Ship {
   EpollEventLoop::EpollEventLoop(
     std::function<Connection*(EventLoop*, ReadWriteCloser *writer)> initializer, int epoll_file_descriptor, int max_events, int timeout, int buffer_size)
-    : UnixEventLoop(std::move(initializer)), epollFileDescriptor(epoll_file_descriptor), maxEvents(max_events), timeout(timeout),
-      buffer(new uint8_t[buffer_size]), bufferSize(buffer_size), epollEvent({EPOLLIN | EPOLLRDHUP | EPOLLET, {}}) {
+    : UnixEventLoop(std::move(initializer)), epollFileDescriptor(epoll_file_descriptor), wakeupFileDescriptor(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      maxEvents(max_events), timeout(timeout), buffer(new uint8_t[buffer_size]), bufferSize(buffer_size), epollEvent({EPOLLIN | EPOLLRDHUP | EPOLLET, {}}) {
+    if (wakeupFileDescriptor != -1) {
+      epoll_event wakeupEvent {EPOLLIN | EPOLLET, {}};
+      wakeupEvent.data.u64 = ConnectionSlab::NONE;
+      if (epoll_ctl(epollFileDescriptor, EPOLL_CTL_ADD, wakeupFileDescriptor, &wakeupEvent) == -1) {
+        close(wakeupFileDescriptor);
+        wakeupFileDescriptor = -1;
+      }
+    }
   }
 
   EpollEventLoop::~EpollEventLoop() {
+    SetOffloader(nullptr);
+    for (const auto& pending : pendingConnects) {
+      close(pending.second.fileDescriptor);
+    }
+
+    for (const auto& lingering : lingeringSockets) {
+      delete lingering.second;
+    }
+
+    if (wakeupFileDescriptor != -1) {
+      close(wakeupFileDescriptor);
+    }
+
     close(epollFileDescriptor);
     delete[] buffer;
   }
 
+  void EpollEventLoop::Wakeup() {
+    if (wakeupFileDescriptor != -1) {
+      eventfd_write(wakeupFileDescriptor, 1);
+    }
+  }
+
   void EpollEventLoop::Accept(int fileDescriptor) {
-    epollEvent.data.ptr = NewConnection(new UnixReadWriteCloser(fileDescriptor));
+    Post([this, fileDescriptor]() {
+      AcceptInLoop(fileDescriptor);
+    });
+  }
+
+  void EpollEventLoop::AcceptInLoop(int fileDescriptor) {
+    socketOptions.ApplyToSocket(fileDescriptor);
+    RegisterConnection(fileDescriptor, nullptr, EPOLL_CTL_ADD);
+  }
+
+  static uint64_t GetCurrentNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void EpollEventLoop::SetBusyPoll(uint64_t spin_micros) {
+    busyPollNanos = spin_micros * 1000;
+  }
+
+  const BusyPollStats& EpollEventLoop::GetBusyPollStats() const {
+    return busyPollStats;
+  }
+
+  void EpollEventLoop::SetSocketOptions(const SocketOptions& options) {
+    socketOptions = options;
+  }
 
-    if (epoll_ctl(epollFileDescriptor, EPOLL_CTL_ADD, fileDescriptor, (epoll_event*) &epollEvent) == -1) {
-      auto connection = (Connection*) epollEvent.data.ptr;
+  const SocketOptions& EpollEventLoop::GetSocketOptions() const {
+    return socketOptions;
+  }
+
+  Connection* EpollEventLoop::RegisterConnection(int fileDescriptor, const ConnectionInitializer& initializer, int operation) {
+    auto* readWriteCloser = new UnixReadWriteCloser(fileDescriptor);
+    if (socketOptions.zeroCopyThreshold != 0) {
+      readWriteCloser->EnableZeroCopy(socketOptions.zeroCopyThreshold);
+    }
+
+    auto connection = initializer ? initializer(this, readWriteCloser) : NewConnection(readWriteCloser);
+    uint64_t handle = connections.Insert(connection, readWriteCloser);
+    connection->SetHandle(handle);
+    epollEvent.data.u64 = handle;
+
+    if (epoll_ctl(epollFileDescriptor, operation, fileDescriptor, (epoll_event*) &epollEvent) == -1) {
+      int error = errno;
+      connections.Remove(handle);
       delete connection;
+      errno = error;
+      return nullptr;
     }
+
+    return connection;
+  }
+
+  void EpollEventLoop::Connect(const SocketAddress& address, uint64_t timeout_millis, ConnectCallback callback, ConnectionInitializer initializer) {
+    Post([this, address, timeout_millis, callback = std::move(callback), initializer = std::move(initializer)]() mutable {
+      ConnectInLoop(address, timeout_millis, std::move(callback), std::move(initializer));
+    });
+  }
+
+  void EpollEventLoop::ConnectInLoop(const SocketAddress& address, uint64_t timeout_millis, ConnectCallback callback, ConnectionInitializer initializer) {
+    sockaddr_storage socketAddress {};
+    socklen_t socketAddressLength;
+    auto* inetAddress = (sockaddr_in*) &socketAddress;
+    auto* inet6Address = (sockaddr_in6*) &socketAddress;
+    if (inet_pton(AF_INET, address.GetHostname().c_str(), &inetAddress->sin_addr) == 1) {
+      inetAddress->sin_family = AF_INET;
+      inetAddress->sin_port = htons(address.GetPort());
+      socketAddressLength = sizeof(sockaddr_in);
+    } else if (inet_pton(AF_INET6, address.GetHostname().c_str(), &inet6Address->sin6_addr) == 1) {
+      inet6Address->sin6_family = AF_INET6;
+      inet6Address->sin6_port = htons(address.GetPort());
+      socketAddressLength = sizeof(sockaddr_in6);
+    } else {
+      errno = EINVAL;
+      callback(ErrnoErrorable<Connection*>(nullptr));
+      return;
+    }
+
+    int fileDescriptor = socket(socketAddress.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fileDescriptor == -1) {
+      callback(ErrnoErrorable<Connection*>(nullptr));
+      return;
+    }
+
+    socketOptions.ApplyBeforeConnect(fileDescriptor);
+    if (connect(fileDescriptor, (sockaddr*) &socketAddress, socketAddressLength) == 0) {
+      Connection* connection = RegisterConnection(fileDescriptor, initializer, EPOLL_CTL_ADD);
+      callback(connection ? (Errorable<Connection*>) SuccessErrorable<Connection*>(connection) : ErrnoErrorable<Connection*>(nullptr));
+      return;
+    }
+
+    // Until the handshake is done the socket is only watched for writability under a tagged id, see CompleteConnect.
+    uint64_t id = ConnectionSlab::TAGGED | nextTaggedID++;
+    epoll_event connectEvent {EPOLLOUT | EPOLLET, {}};
+    connectEvent.data.u64 = id;
+    if (errno != EINPROGRESS || epoll_ctl(epollFileDescriptor, EPOLL_CTL_ADD, fileDescriptor, &connectEvent) == -1) {
+      ErrnoErrorable<Connection*> errorable(nullptr);
+      close(fileDescriptor);
+      callback(errorable);
+      return;
+    }
+
+    pendingConnects.emplace(id, PendingConnect {fileDescriptor, std::move(initializer), std::move(callback)});
+    if (timeout_millis != 0) {
+      Delay([this, id]() {
+        CompleteConnect(id, ETIMEDOUT);
+      }, timeout_millis);
+    }
+  }
+
+  void EpollEventLoop::CompleteConnect(uint64_t id, int error) {
+    auto pendingIterator = pendingConnects.find(id);
+    if (pendingIterator == pendingConnects.end()) {
+      return;
+    }
+
+    PendingConnect pending = std::move(pendingIterator->second);
+    pendingConnects.erase(pendingIterator);
+
+    if (error == 0) {
+      // Re-registering under the connection handle reports bytes that may already have arrived.
+      Connection* connection = RegisterConnection(pending.fileDescriptor, pending.initializer, EPOLL_CTL_MOD);
+      if (connection) {
+        pending.callback(SuccessErrorable<Connection*>(connection));
+        return;
+      }
+
+      error = errno;
+    } else {
+      close(pending.fileDescriptor);
+    }
+
+    errno = error;
+    pending.callback(ErrnoErrorable<Connection*>(nullptr));
+  }
+
+  void EpollEventLoop::SetReadBudget(size_t max_bytes, size_t max_packets) {
+    maxReadBytes = max_bytes;
+    maxReadPackets = max_packets;
+  }
+
+  uint64_t EpollEventLoop::GetReadBudgetExhaustions() const {
+    return readBudgetExhaustions;
+  }
+
+  const Log2Histogram& EpollEventLoop::GetReadBudgetStreaks() const {
+    return readBudgetStreaks;
+  }
+
+  EpollEventLoop::ReadResult EpollEventLoop::ToReadResult(PassthroughResult result) {
+    switch (result) {
+      case PassthroughResult::DRAINED:
+        return ReadResult::DRAINED;
+      case PassthroughResult::BUDGET_EXHAUSTED:
+        return ReadResult::BUDGET_EXHAUSTED;
+      default:
+        return ReadResult::CLOSED;
+    }
+  }
+
+  EpollEventLoop::ReadResult EpollEventLoop::ReadConnection(Connection* connection) {
+    Passthrough* passthrough = connection->GetPassthrough();
+    if (passthrough) {
+      return ToReadResult(passthrough->OnReadable(connection, maxReadBytes));
+    }
+
+    size_t bytesRead = 0;
+    size_t packetsRead = 0;
+    if (maxReadPackets != 0) {
+      // Complete frames the packet budget left buffered in an earlier turn come before new reads.
+      packetsRead = connection->HandleBufferedPackets(maxReadPackets);
+    }
+
+    while (true) {
+      if ((maxReadBytes != 0 && bytesRead >= maxReadBytes) || (maxReadPackets != 0 && packetsRead >= maxReadPackets)) {
+        return ReadResult::BUDGET_EXHAUSTED;
+      }
+
+      Errorable<ssize_t> readRequest = connection->GetReadWriteCloser()->Read(buffer, bufferSize);
+
+      if (readRequest.GetTypeOrdinal() == SuccessErrorable<ssize_t>::TYPE_ORDINAL && readRequest.GetValue() > 0) {
+        bytesRead += readRequest.GetValue();
+        packetsRead += connection->HandleNewBytes(buffer, (size_t) readRequest.GetValue(), maxReadPackets == 0 ? 0 : maxReadPackets - packetsRead);
+      } else if (readRequest.GetTypeOrdinal() == ErrnoErrorable<ssize_t>::TYPE_ORDINAL && errno == EAGAIN) {
+        return ReadResult::DRAINED;
+      } else {
+        // TODO: Log exception via logger class
+        return ReadResult::CLOSED;
+      }
+    }
+  }
+
+  void EpollEventLoop::ServeConnection(Connection* connection) {
+    ApplyReadResult(connection, ReadConnection(connection));
+  }
+
+  void EpollEventLoop::ServePassthrough(Connection* connection, uint32_t events) {
+    Passthrough* passthrough = connection->GetPassthrough();
+    if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+      // A source that is already on the ready list drains towards this connection on its own turn.
+      Connection* source = passthrough->GetPeer(connection);
+      if (readBudgetStreakMap.find(source) == readBudgetStreakMap.end()) {
+        ApplyReadResult(source, ToReadResult(passthrough->OnWritable(connection, maxReadBytes)));
+        if (!connection->GetPassthrough()) {
+          return;
+        }
+      }
+    }
+
+    if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) && readBudgetStreakMap.find(connection) == readBudgetStreakMap.end()) {
+      ServeConnection(connection);
+    }
+  }
+
+  void EpollEventLoop::ApplyReadResult(Connection* connection, ReadResult result) {
+    switch (result) {
+      case ReadResult::DRAINED: {
+        auto streak = readBudgetStreakMap.find(connection);
+        if (streak != readBudgetStreakMap.end()) {
+          readBudgetStreaks.Record(streak->second);
+          readBudgetStreakMap.erase(streak);
+        }
+
+        break;
+      }
+      case ReadResult::BUDGET_EXHAUSTED: {
+        ++readBudgetExhaustions;
+        ++readBudgetStreakMap[connection];
+        readyConnections.push_back(connection);
+        break;
+      }
+      case ReadResult::CLOSED: {
+        CloseConnection(connection);
+        break;
+      }
+    }
+  }
+
+  void EpollEventLoop::CloseConnection(Connection* connection) {
+    UnixReadWriteCloser* socket = connections.GetReadWriteCloser(connection->GetHandle());
+    if (!connections.Remove(connection->GetHandle())) {
+      return;
+    }
+
+    if (readBudgetStreakMap.erase(connection) != 0) {
+      readyConnections.erase(std::remove(readyConnections.begin(), readyConnections.end(), connection), readyConnections.end());
+      carriedConnections.erase(std::remove(carriedConnections.begin(), carriedConnections.end(), connection), carriedConnections.end());
+    }
+
+    Passthrough* passthrough = connection->GetPassthrough();
+    if (passthrough) {
+      Connection* peer = passthrough->GetPeer(connection);
+      connection->SetPassthrough(nullptr);
+      peer->SetPassthrough(nullptr);
+      delete passthrough;
+      CloseConnection(peer);
+    }
+
+    // Events for this connection may still be queued in the current batch, so it is deleted only once the tick is over.
+    connection->GetReadWriteCloser()->Close();
+    closedConnections.emplace_back(connection, socket);
+  }
+
+  void EpollEventLoop::DeleteClosedConnections() {
+    for (const auto& closed : closedConnections) {
+      // Close kept the socket open for the completions of its zero-copy sends, the loop takes it over until they arrived.
+      UnixReadWriteCloser* socket = closed.second;
+      if (socket && socket->GetPendingZeroCopySends() != 0 && closed.first->GetReadWriteCloser() == socket) {
+        closed.first->ReleaseReadWriteCloser();
+        LingerSocket(socket);
+      }
+
+      delete closed.first;
+    }
+
+    closedConnections.clear();
+  }
+
+  void EpollEventLoop::LingerSocket(UnixReadWriteCloser* socket) {
+    // Errors are always reported, so the socket wakes the loop for every batch of completions under its own tagged id.
+    uint64_t id = ConnectionSlab::TAGGED | nextTaggedID++;
+    epoll_event lingerEvent {EPOLLET, {}};
+    lingerEvent.data.u64 = id;
+    if (epoll_ctl(epollFileDescriptor, EPOLL_CTL_MOD, socket->GetFileDescriptor(), &lingerEvent) == -1) {
+      delete socket;
+      return;
+    }
+
+    lingeringSockets.emplace(id, socket);
+    Delay([this, id]() {
+      ReleaseLingeringSocket(id, true);
+    }, ZERO_COPY_LINGER_MILLIS);
+  }
+
+  void EpollEventLoop::ReleaseLingeringSocket(uint64_t id, bool expired) {
+    auto lingering = lingeringSockets.find(id);
+    if (lingering == lingeringSockets.end()) {
+      return;
+    }
+
+    UnixReadWriteCloser* socket = lingering->second;
+    socket->ReadZeroCopyCompletions();
+    if (socket->GetPendingZeroCopySends() != 0 && !expired) {
+      return;
+    }
+
+    // Deleting closes the socket, sends still in flight after the linger leave their segments to the kernel.
+    lingeringSockets.erase(lingering);
+    delete socket;
+  }
+
+  Errorable<Passthrough*> EpollEventLoop::StartPassthrough(Connection* first, Connection* second, size_t chunk_size) {
+    if (FindConnection(first->GetHandle()) != first || FindConnection(second->GetHandle()) != second || first->GetPassthrough()
+        || second->GetPassthrough()) {
+      return InvalidPassthroughErrorable(0);
+    }
+
+    ProceedErrorable(passthrough, Passthrough*, Passthrough::NewPassthrough(first, second, chunk_size), InvalidPassthroughErrorable(0))
+    first->SetPassthrough(passthrough);
+    second->SetPassthrough(passthrough);
+
+    // Re-arming with EPOLLOUT reports both sockets right away, which flushes the bytes handed over from the old pipeline.
+    for (Connection* connection : {first, second}) {
+      epoll_event passthroughEvent {EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, {}};
+      passthroughEvent.data.u64 = connection->GetHandle();
+      int fileDescriptor = connections.GetReadWriteCloser(connection->GetHandle())->GetFileDescriptor();
+      if (epoll_ctl(epollFileDescriptor, EPOLL_CTL_MOD, fileDescriptor, &passthroughEvent) == -1) {
+        ErrnoErrorable<Passthrough*> errorable(nullptr);
+        CloseConnection(first);
+        return errorable;
+      }
+    }
+
+    return SuccessErrorable<Passthrough*>(passthrough);
+  }
+
+  void EpollEventLoop::SetIdleBufferRelease(uint64_t idle_millis) {
+    idleBufferReleaseMillis = idle_millis;
+    nextIdleSweepMillis = 0;
+  }
+
+  void EpollEventLoop::SweepIdleConnections() {
+    uint64_t currentMillis = ShipUtils::GetCurrentMillis();
+    if (currentMillis < nextIdleSweepMillis) {
+      return;
+    }
+
+    for (Connection* connection : connections.GetConnections()) {
+      connection->ReleaseIdleBuffers(currentMillis, idleBufferReleaseMillis);
+    }
+
+    nextIdleSweepMillis = currentMillis + idleBufferReleaseMillis;
+  }
+
+  size_t EpollEventLoop::GetConnectionCount() const {
+    return connections.GetSize();
+  }
+
+  Connection* EpollEventLoop::FindConnection(uint64_t handle) const {
+    return connections.Get(handle);
+  }
+
+  size_t EpollEventLoop::GetResidentBufferBytes() const {
+    size_t residentBytes = 0;
+    for (Connection* connection : connections.GetConnections()) {
+      residentBytes += connection->GetResidentBufferBytes();
+    }
+
+    return residentBytes;
   }
 
   [[noreturn]] void EpollEventLoop::StartLoop() {
     epoll_event events[maxEvents];
     epoll_event event; // NOLINT(cppcoreguidelines-pro-type-member-init)
 
+    uint64_t waitEndNanos = 0;
+
     while (true) {
       ProceedTasks();
-      int amount = epoll_wait(epollFileDescriptor, (epoll_event*) events, maxEvents, timeout);
+      int waitTimeout = readyConnections.empty() ? timeout : 0;
+      int64_t untilDelayed = GetMillisUntilNextDelayed();
+      if (untilDelayed >= 0 && (waitTimeout < 0 || untilDelayed < waitTimeout)) {
+        waitTimeout = (int) untilDelayed;
+      }
+
+      uint64_t waitStartNanos = 0;
+      bool spinning = false;
+      if (busyPollNanos != 0) {
+        waitStartNanos = GetCurrentNanos();
+        if (waitEndNanos != 0) {
+          busyPollStats.workNanos += waitStartNanos - waitEndNanos;
+        }
+
+        // Right after activity the next event is likely close, polling catches it without the cost of a blocking wakeup.
+        spinning = waitStartNanos - lastActivityNanos < busyPollNanos;
+        if (spinning) {
+          waitTimeout = 0;
+        }
+      }
+
+      int amount = epoll_wait(epollFileDescriptor, (epoll_event*) events, maxEvents, waitTimeout);
+
+      if (busyPollNanos != 0) {
+        waitEndNanos = GetCurrentNanos();
+        if (!spinning) {
+          ++busyPollStats.blockingWaits;
+        } else if (amount > 0) {
+          ++busyPollStats.spinHits;
+        } else {
+          ++busyPollStats.emptySpins;
+          busyPollStats.spinNanos += waitEndNanos - waitStartNanos;
+        }
+
+        if (amount > 0 || !readyConnections.empty()) {
+          lastActivityNanos = waitEndNanos;
+        }
+      }
+
+      // Only connections that ran out of budget in an earlier tick get their extra turn below, the ones exhausting it now wait for the next tick.
+      readyConnections.swap(carriedConnections);
 
-      bool disconnected;
       for (int i = 0; i < amount; ++i) {
         event = events[i];
-        auto connection = (Connection *) event.data.ptr;
+        if (event.data.u64 == ConnectionSlab::NONE) {
+          eventfd_t value;
+          eventfd_read(wakeupFileDescriptor, &value);
+          continue;
+        }
 
-        if (event.events & EPOLLRDHUP) {
-          delete connection;
-        } else {
-          while (true) {
-            Errorable<ssize_t> readRequest = connection->GetReadWriteCloser()->Read(buffer, bufferSize);
-
-            if (readRequest.GetTypeOrdinal() == SuccessErrorable<ssize_t>::TYPE_ORDINAL) {
-              connection->HandleNewBytes(buffer, (size_t) readRequest.GetValue());
-            } else if (readRequest.GetTypeOrdinal() == ErrnoErrorable<ssize_t>::TYPE_ORDINAL && errno == EAGAIN) {
-              break;
-            } else if (readRequest.GetTypeOrdinal() == GracefulDisconnectErrorable::TYPE_ORDINAL) {
-              delete connection;
-              disconnected = true;
-              break;
-            } else {
-              // TODO: Log exception via logger class
-              delete connection;
-              disconnected = true;
-              break;
+        if (event.data.u64 & ConnectionSlab::TAGGED) {
+          auto pending = pendingConnects.find(event.data.u64);
+          if (pending != pendingConnects.end()) {
+            int error = 0;
+            socklen_t errorLength = sizeof(error);
+            if (getsockopt(pending->second.fileDescriptor, SOL_SOCKET, SO_ERROR, &error, &errorLength) == -1) {
+              error = errno;
             }
+
+            CompleteConnect(event.data.u64, error);
+          } else {
+            ReleaseLingeringSocket(event.data.u64, false);
           }
 
-          if (disconnected) {
-            break;
+          continue;
+        }
+
+        // Stale for connections closed earlier in this batch, their slot generation has moved on.
+        Connection* connection = connections.Get(event.data.u64);
+        if (connection == nullptr) {
+          continue;
+        }
+
+        // Zero-copy completions are reported through the error queue, which alone doesn't mean the socket failed.
+        if (event.events & EPOLLERR) {
+          UnixReadWriteCloser* socket = connections.GetReadWriteCloser(event.data.u64);
+          if (socket && socket->IsZeroCopyEnabled() && socket->ReadZeroCopyCompletions() && event.events == EPOLLERR) {
+            int error = 0;
+            socklen_t errorLength = sizeof(error);
+            if (getsockopt(socket->GetFileDescriptor(), SOL_SOCKET, SO_ERROR, &error, &errorLength) == -1) {
+              error = errno;
+            }
+
+            // Reading SO_ERROR clears it, so a failed socket is closed here, a read wouldn't report it anymore.
+            if (error != 0) {
+              CloseConnection(connection);
+            }
+
+            continue;
           }
         }
+
+        if (connection->GetPassthrough()) {
+          ServePassthrough(connection, event.events);
+        } else if (event.events & EPOLLRDHUP) {
+          CloseConnection(connection);
+        } else if (readBudgetStreakMap.find(connection) == readBudgetStreakMap.end()) {
+          ServeConnection(connection);
+        }
       }
+
+      // Edge-triggered epoll won't notify about the bytes left behind, so every connection that ran out of budget gets one more turn per tick.
+      while (!carriedConnections.empty()) {
+        Connection* connection = carriedConnections.front();
+        carriedConnections.pop_front();
+        ServeConnection(connection);
+      }
+
+      if (idleBufferReleaseMillis != 0) {
+        SweepIdleConnections();
+      }
+
+      DeleteClosedConnections();
     }
   }
 
@@ -0,0 +1,164 @@
+#ifdef __linux__
+  #include "EventLoopGroup.hpp"
+  #include "../../protocol/SegmentPool.hpp"
+  #include <algorithm>
+  #include <cerrno>
+  #include <future>
+  #include <linux/mempolicy.h>
+  #include <pthread.h>
+  #include <sched.h>
+  #include <sys/socket.h>
+  #include <sys/syscall.h>
+  #include <thread>
+  #include <unistd.h>
+
+namespace Ship {
+  CreateInvalidArgumentErrorable(InvalidCPUErrorable, EventLoopGroup*, "CPU is out of range, cpu");
+  CreateInvalidArgumentErrorable(EmptyCPUSetErrorable, EventLoopGroup*, "CPU set has no CPUs, set index");
+  CreateInvalidArgumentErrorable(NoCPUSetsErrorable, EventLoopGroup*, "Event loop group needs at least one CPU set, sets");
+
+  Errorable<EpollEventLoop*> EventLoopGroup::StartPinnedLoop(const ConnectionInitializer& initializer, const std::vector<int>& cpus, int max_events,
+    int timeout, int buffer_size, const EventLoopConfigurer& configurer, int* numa_node) {
+    std::promise<Errorable<EpollEventLoop*>> started;
+    std::future<Errorable<EpollEventLoop*>> startedFuture = started.get_future();
+
+    std::thread([started = std::move(started), initializer, cpus, max_events, timeout, buffer_size, configurer, numa_node]() mutable {
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      for (int cpu : cpus) {
+        CPU_SET(cpu, &cpuSet);
+      }
+
+      int error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+      if (error != 0) {
+        errno = error;
+        started.set_value(ErrnoErrorable<EpollEventLoop*>(nullptr));
+        return;
+      }
+
+      // First touch decides the node of a page, the local policy overrides an interleaving one inherited from the process.
+      // Kernels without NUMA support reject it, which changes nothing for them.
+      syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0);
+
+      unsigned int currentCPU;
+      unsigned int currentNode;
+      if (syscall(SYS_getcpu, &currentCPU, &currentNode, nullptr) == 0) {
+        *numa_node = (int) currentNode;
+      }
+
+      SegmentPool::Local();
+      Errorable<EpollEventLoop*> loop = EpollEventLoop::NewEventLoop(initializer, max_events, timeout, buffer_size);
+      EpollEventLoop* startedLoop = loop.GetValue();
+      started.set_value(loop);
+      if (startedLoop == nullptr) {
+        return;
+      }
+
+      if (configurer) {
+        configurer(startedLoop);
+      }
+
+      startedLoop->StartLoop();
+    }).detach();
+
+    return startedFuture.get();
+  }
+
+  Errorable<EventLoopGroup*> EventLoopGroup::NewEventLoopGroup(const ConnectionInitializer& initializer,
+    const std::vector<std::vector<int>>& cpu_sets, int max_events, int timeout, int buffer_size, const EventLoopConfigurer& configurer,
+    size_t huge_page_arena_bytes) {
+    if (cpu_sets.empty()) {
+      return NoCPUSetsErrorable(0);
+    }
+
+    int maxCPU = -1;
+    for (size_t i = 0; i < cpu_sets.size(); ++i) {
+      const std::vector<int>& cpus = cpu_sets[i];
+      if (cpus.empty()) {
+        return EmptyCPUSetErrorable(i);
+      }
+
+      for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+          return InvalidCPUErrorable(cpu);
+        }
+
+        maxCPU = std::max(maxCPU, cpu);
+      }
+    }
+
+    if (huge_page_arena_bytes != 0) {
+      SegmentPool::EnableHugePageSlabs(huge_page_arena_bytes);
+    }
+
+    auto* group = new EventLoopGroup();
+    group->cpuToLoop.assign(maxCPU + 1, -1);
+    for (const auto& cpus : cpu_sets) {
+      int numaNode = -1;
+      Errorable<EpollEventLoop*> loop = StartPinnedLoop(initializer, cpus, max_events, timeout, buffer_size, configurer, &numaNode);
+      if (!loop.IsSuccess()) {
+        // Loops that already started keep running, StartLoop never returns.
+        delete group;
+        return Errorable<EventLoopGroup*>(loop.GetTypeOrdinal(), nullptr, loop.GetErrorCode());
+      }
+
+      for (int cpu : cpus) {
+        group->cpuToLoop[cpu] = (int) group->loops.size();
+      }
+
+      group->loops.push_back(loop.GetValue());
+      group->numaNodes.push_back(numaNode);
+    }
+
+    return SuccessErrorable<EventLoopGroup*>(group);
+  }
+
+  EpollEventLoop* EventLoopGroup::GetLoopForCPU(int cpu) const {
+    if (cpu < 0 || (size_t) cpu >= cpuToLoop.size() || cpuToLoop[cpu] == -1) {
+      return nullptr;
+    }
+
+    return loops[cpuToLoop[cpu]];
+  }
+
+  void EventLoopGroup::Accept(int fileDescriptor) {
+    EpollEventLoop* loop = nullptr;
+  #ifdef SO_INCOMING_CPU
+    int incomingCPU = -1;
+    socklen_t length = sizeof(int);
+    if (getsockopt(fileDescriptor, SOL_SOCKET, SO_INCOMING_CPU, &incomingCPU, &length) == 0) {
+      loop = GetLoopForCPU(incomingCPU);
+    }
+  #endif
+
+    if (loop) {
+      steeredAccepts.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      unsteeredAccepts.fetch_add(1, std::memory_order_relaxed);
+      loop = loops[nextLoop.fetch_add(1, std::memory_order_relaxed) % loops.size()];
+    }
+
+    loop->Accept(fileDescriptor);
+  }
+
+  size_t EventLoopGroup::GetLoopCount() const {
+    return loops.size();
+  }
+
+  EpollEventLoop* EventLoopGroup::GetLoop(size_t index) const {
+    return loops[index];
+  }
+
+  int EventLoopGroup::GetNumaNode(size_t index) const {
+    return numaNodes[index];
+  }
+
+  uint64_t EventLoopGroup::GetSteeredAccepts() const {
+    return steeredAccepts.load(std::memory_order_relaxed);
+  }
+
+  uint64_t EventLoopGroup::GetUnsteeredAccepts() const {
+    return unsteeredAccepts.load(std::memory_order_relaxed);
+  }
+}
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "NetworkEventLoop.hpp"
+
+#ifdef __linux__
+  #include <atomic>
+  #include <vector>
+
+namespace Ship {
+  using EventLoopConfigurer = std::function<void(EpollEventLoop*)>;
+
+  // Runs one EpollEventLoop per CPU set, every loop is created on its own pinned thread under a local memory policy,
+  // so its read buffer, slab and the SegmentPool of the thread are allocated on the NUMA node of its CPUs.
+  // Loops never return from StartLoop, so the group lives as long as the process.
+  class EventLoopGroup {
+   private:
+    std::vector<EpollEventLoop*> loops;
+    std::vector<int> numaNodes;
+    // Indexed by CPU, -1 for CPUs that no loop is pinned to.
+    std::vector<int> cpuToLoop;
+    std::atomic<size_t> nextLoop {0};
+    std::atomic<uint64_t> steeredAccepts {0};
+    std::atomic<uint64_t> unsteeredAccepts {0};
+
+    EventLoopGroup() = default;
+
+    static Errorable<EpollEventLoop*> StartPinnedLoop(const ConnectionInitializer& initializer, const std::vector<int>& cpus, int max_events,
+      int timeout, int buffer_size, const EventLoopConfigurer& configurer, int* numa_node);
+
+   public:
+    // Needs at least one CPU set and every set needs at least one CPU, both are checked before any loop starts.
+    // The configurer runs on every loop thread right before StartLoop.
+    // A non-zero huge page arena makes segment buffers come from huge page slabs, see SegmentPool::EnableHugePageSlabs.
+    static Errorable<EventLoopGroup*> NewEventLoopGroup(const ConnectionInitializer& initializer, const std::vector<std::vector<int>>& cpu_sets,
+      int max_events, int timeout, int buffer_size, const EventLoopConfigurer& configurer = nullptr, size_t huge_page_arena_bytes = 0);
+
+    // Hands the socket to the loop pinned to the CPU that processed its receive queue, falling back to round robin.
+    void Accept(int fileDescriptor);
+    [[nodiscard]] EpollEventLoop* GetLoopForCPU(int cpu) const;
+
+    [[nodiscard]] size_t GetLoopCount() const;
+    [[nodiscard]] EpollEventLoop* GetLoop(size_t index) const;
+    // -1 if the node couldn't be determined.
+    [[nodiscard]] int GetNumaNode(size_t index) const;
+    [[nodiscard]] uint64_t GetSteeredAccepts() const;
+    [[nodiscard]] uint64_t GetUnsteeredAccepts() const;
+  };
+}
+#endif
@@ -23,6 +23,7 @@ namespace Ship {
   }
 
   KqueueEventLoop::~KqueueEventLoop() {
+    SetOffloader(nullptr);
     close(kqueueFileDescriptor);
     delete[] buffer;
     delete[] errorBuffer;
@@ -30,13 +31,19 @@ namespace Ship {
 
   void KqueueEventLoop::Accept(int fileDescriptor) {
     EV_SET(&kevent, fileDescriptor, EVFILT_READ, EV_ADD, 0, 0, nullptr);
-    kevent.udata = NewConnection(new UnixReadWriteCloser(fileDescriptor));
+    auto connection = NewConnection(new UnixReadWriteCloser(fileDescriptor));
+    connection->SetHandle(connections.Insert(connection));
+    kevent.udata = connection;
     if (::kevent(kqueueFileDescriptor, &kevent, 1, nullptr, 0, nullptr) == -1) {
-      auto connection = (Connection*) kevent.udata;
+      connections.Remove(connection->GetHandle());
       delete connection;
     }
   }
 
+  Connection* KqueueEventLoop::FindConnection(uint64_t handle) const {
+    return connections.Get(handle);
+  }
+
   [[noreturn]] void KqueueEventLoop::StartLoop() {
     struct kevent events[maxEvents];
     struct kevent event; // NOLINT(cppcoreguidelines-pro-type-member-init)
@@ -70,6 +77,7 @@ namespace Ship {
             }
           }
         } catch (const GracefulDisconnectErrorable& exception) {
+          connections.Remove(connection->GetHandle());
           delete connection;
         }
 
@@ -1,10 +1,17 @@
 #pragma once
 
+#include "../../utils/metric/Log2Histogram.hpp"
 #include "../../utils/thread/EventLoop.hpp"
 #include "../Connection.hpp"
+#include "../SocketAddress.hpp"
+#include "../SocketOptions.hpp"
+#include "../passthrough/Passthrough.hpp"
+#include "ConnectionSlab.hpp"
 
 #ifdef __linux__
+  #include <deque>
   #include <sys/epoll.h>
+  #include <unordered_map>
 #endif
 
 #if defined(__APPLE__) || defined(__FreeBSD__)
@@ -36,6 +43,9 @@ namespace Ship {
     inline Connection* NewConnection(ReadWriteCloser* writer) {
       return initializer(this, writer);
     }
+
+    // Resolves a handle taken from Connection::GetHandle, nullptr once the connection is closed. Loop thread only.
+    [[nodiscard]] virtual Connection* FindConnection(uint64_t handle) const = 0;
   };
 
   class UnixEventLoop : public NetworkEventLoop {
@@ -49,16 +59,85 @@ namespace Ship {
   };
 
 #ifdef __linux__
+  using ConnectionInitializer = std::function<Connection*(EventLoop*, ReadWriteCloser*)>;
+  using ConnectCallback = std::function<void(Errorable<Connection*>)>;
+
+  class PendingConnect {
+   public:
+    int fileDescriptor;
+    ConnectionInitializer initializer;
+    ConnectCallback callback;
+  };
+
+  class BusyPollStats {
+   public:
+    // Spent in zero-timeout epoll_wait calls that returned nothing.
+    uint64_t spinNanos = 0;
+    // Spent between two waits, handling events and tasks.
+    uint64_t workNanos = 0;
+    uint64_t emptySpins = 0;
+    // Spins that found events, each of them is a blocking wakeup saved.
+    uint64_t spinHits = 0;
+    uint64_t blockingWaits = 0;
+  };
+
   class EpollEventLoop : public UnixEventLoop {
    private:
     int epollFileDescriptor;
+    int wakeupFileDescriptor;
     int maxEvents;
     int timeout;
     uint8_t* buffer;
     int bufferSize;
     epoll_event epollEvent;
+    size_t maxReadBytes = 0;
+    size_t maxReadPackets = 0;
+    std::deque<Connection*> readyConnections;
+    // The ready list taken over at the start of a tick, served after the event pass.
+    std::deque<Connection*> carriedConnections;
+    std::unordered_map<Connection*, uint64_t> readBudgetStreakMap;
+    uint64_t readBudgetExhaustions = 0;
+    Log2Histogram readBudgetStreaks;
+    ConnectionSlab connections;
+    // Closed connections with the socket the loop created for them, the slab forgets it on close.
+    std::vector<std::pair<Connection*, UnixReadWriteCloser*>> closedConnections;
+    // Sockets of deleted connections that wait for their zero-copy completions, keyed by ConnectionSlab::TAGGED ids.
+    std::unordered_map<uint64_t, UnixReadWriteCloser*> lingeringSockets;
+    uint64_t idleBufferReleaseMillis = 0;
+    uint64_t nextIdleSweepMillis = 0;
+    // Keyed by ConnectionSlab::TAGGED ids, which is what their epoll events carry.
+    std::unordered_map<uint64_t, PendingConnect> pendingConnects;
+    uint64_t nextTaggedID = 0;
+    SocketOptions socketOptions;
+    uint64_t busyPollNanos = 0;
+    uint64_t lastActivityNanos = 0;
+    BusyPollStats busyPollStats;
+
+    enum class ReadResult {
+      DRAINED,
+      BUDGET_EXHAUSTED,
+      CLOSED
+    };
+
+    static ReadResult ToReadResult(PassthroughResult result);
+    ReadResult ReadConnection(Connection* connection);
+    void ServeConnection(Connection* connection);
+    void ServePassthrough(Connection* connection, uint32_t events);
+    void ApplyReadResult(Connection* connection, ReadResult result);
+    void CloseConnection(Connection* connection);
+    void DeleteClosedConnections();
+    void AcceptInLoop(int fileDescriptor);
+    void ConnectInLoop(const SocketAddress& address, uint64_t timeout_millis, ConnectCallback callback, ConnectionInitializer initializer);
+    void CompleteConnect(uint64_t id, int error);
+    void LingerSocket(UnixReadWriteCloser* socket);
+    void ReleaseLingeringSocket(uint64_t id, bool expired);
+    Connection* RegisterConnection(int fileDescriptor, const ConnectionInitializer& initializer, int operation);
+    void SweepIdleConnections();
 
    public:
+    // How long a closed socket is kept open for the completions of its zero-copy sends before their segments are given up.
+    static const uint64_t ZERO_COPY_LINGER_MILLIS = 10000;
+
     static Errorable<EpollEventLoop*> NewEventLoop(std::function<Connection*(EventLoop*, ReadWriteCloser*)> initializer, int max_events, int timeout, int buffer_size);
 
     EpollEventLoop(std::function<Connection*(EventLoop*, ReadWriteCloser*)> initializer, int epoll_file_descriptor, int max_events, int timeout, int buffer_size);
@@ -66,6 +145,37 @@ namespace Ship {
     ~EpollEventLoop() override;
 
     void Accept(int fileDescriptor) override;
+    void Wakeup() override;
+
+    // Zero disables the corresponding limit. Packets are handled frames, a turn can stop with complete frames still buffered.
+    void SetReadBudget(size_t max_bytes, size_t max_packets);
+    [[nodiscard]] uint64_t GetReadBudgetExhaustions() const;
+    // Lengths of consecutive ticks a connection spent exhausting its budget before it got drained.
+    [[nodiscard]] const Log2Histogram& GetReadBudgetStreaks() const;
+
+    // Connections that stayed silent for this long give their drained buffers back to the SegmentPool. Zero disables it.
+    void SetIdleBufferRelease(uint64_t idle_millis);
+    [[nodiscard]] size_t GetConnectionCount() const;
+    [[nodiscard]] Connection* FindConnection(uint64_t handle) const override;
+    [[nodiscard]] size_t GetResidentBufferBytes() const;
+
+    // Detaches both connections from their pipes and handlers and forwards raw bytes between them with proper half-close handling.
+    // Both connections must belong to this loop and the call has to happen on the loop thread. Fails while a pipe of either
+    // connection still buffers input, see Connection::HasPipelineInput.
+    Errorable<Passthrough*> StartPassthrough(Connection* first, Connection* second, size_t chunk_size);
+
+    // Keeps calling epoll_wait without blocking for this long after the last event, zero disables it. Set it before StartLoop.
+    void SetBusyPoll(uint64_t spin_micros);
+    // Only updated while busy polling is enabled, read it on the loop thread.
+    [[nodiscard]] const BusyPollStats& GetBusyPollStats() const;
+
+    // Applied to every accepted and connected socket of this loop, failures of single options are ignored there.
+    void SetSocketOptions(const SocketOptions& options);
+    [[nodiscard]] const SocketOptions& GetSocketOptions() const;
+
+    // Non-blocking connect to a numeric IPv4 or IPv6 address, the callback runs on the loop thread once the socket is writable,
+    // the connect failed or the timeout passed. Zero disables the timeout, a null initializer uses the one of the loop.
+    void Connect(const SocketAddress& address, uint64_t timeout_millis, ConnectCallback callback, ConnectionInitializer initializer = nullptr);
 
     [[noreturn]] void StartLoop() override;
   };
@@ -84,6 +194,7 @@ namespace Ship {
     uint8_t* buffer;
     int bufferSize;
     struct kevent kevent {};
+    ConnectionSlab connections;
 
    public:
     KqueueEventLoop(std::function<Connection*(EventLoop*, ReadWriteCloser*)> initializer, int max_events, const timespec* timeout, int buffer_size);
@@ -91,6 +202,7 @@ namespace Ship {
     ~KqueueEventLoop() override;
 
     void Accept(int fileDescriptor) override;
+    [[nodiscard]] Connection* FindConnection(uint64_t handle) const override;
 
     [[noreturn]] void StartLoop() override;
   };
@@ -12,12 +12,20 @@ namespace Ship {
   EpollListener::EpollListener(EpollEventLoop* event_loop, int max_events, int timeout) : eventLoop(event_loop), maxEvents(max_events), timeout(timeout) {
   }
 
+  EpollListener::EpollListener(EventLoopGroup* event_loop_group, int max_events, int timeout)
+    : eventLoop(nullptr), eventLoopGroup(event_loop_group), maxEvents(max_events), timeout(timeout) {
+  }
+
   EpollListener::~EpollListener() {
     close(epollFileDescriptor);
     close(socketFileDescriptor);
     delete eventLoop;
   }
 
+  void EpollListener::SetSocketOptions(const SocketOptions& options) {
+    socketOptions = options;
+  }
+
   Errorable<int> EpollListener::Bind(SocketAddress address) {
     socketFileDescriptor = socket(AF_INET, SOCK_STREAM, 0);
     if (socketFileDescriptor == -1) {
@@ -38,7 +46,12 @@ namespace Ship {
       return ErrnoErrorable<int>(socketFileDescriptor);
     }
 
-    if (listen(socketFileDescriptor, SOMAXCONN) == -1) {
+    Errorable<int> optionsErrorable = socketOptions.ApplyToListener(socketFileDescriptor);
+    if (!optionsErrorable.IsSuccess()) {
+      return optionsErrorable;
+    }
+
+    if (listen(socketFileDescriptor, socketOptions.backlog) == -1) {
       return ErrnoErrorable<int>(socketFileDescriptor);
     }
 
@@ -87,6 +100,8 @@ namespace Ship {
             close(event.data.fd);
             close(epollFileDescriptor);
             break;
+          } else if (eventLoopGroup) {
+            eventLoopGroup->Accept(receivedFileDescriptor.GetValue());
           } else {
             eventLoop->Accept(receivedFileDescriptor.GetValue());
           }
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "../eventloop/EventLoopGroup.hpp"
 #include "../eventloop/NetworkEventLoop.hpp"
 #include "../Connection.hpp"
 #include "../SocketAddress.hpp"
+#include "../SocketOptions.hpp"
 #include "../pipe/Pipe.hpp"
 #include <functional>
 #include <list>
@@ -22,15 +24,21 @@ namespace Ship {
   class EpollListener : public Listener {
    private:
     EpollEventLoop* eventLoop;
+    EventLoopGroup* eventLoopGroup = nullptr;
     int maxEvents;
     int timeout;
     int epollFileDescriptor {};
     int socketFileDescriptor {};
+    SocketOptions socketOptions;
 
    public:
     ~EpollListener() override;
 
     EpollListener(EpollEventLoop* event_loop, int max_events, int timeout);
+    // Accepted sockets are spread over the loops of the group, see EventLoopGroup::Accept.
+    EpollListener(EventLoopGroup* event_loop_group, int max_events, int timeout);
+    // Listener level options and the backlog, has to be called before Bind. Accepted sockets use the options of the loop.
+    void SetSocketOptions(const SocketOptions& options);
     Errorable<int> Bind(SocketAddress address) override;
     [[noreturn]] void StartListening() override;
   };
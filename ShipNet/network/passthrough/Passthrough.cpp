@@ -0,0 +1,213 @@
+#include "Passthrough.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace Ship {
+  Passthrough::Passthrough(Connection* first, int first_file_descriptor, Connection* second, int second_file_descriptor, size_t chunk_size)
+    : directions {{first, second, first_file_descriptor, second_file_descriptor, {-1, -1}, nullptr, 0, 0, false, false},
+      {second, first, second_file_descriptor, first_file_descriptor, {-1, -1}, nullptr, 0, 0, false, false}},
+      chunkSize(chunk_size), useSplice(false) {
+#ifdef __linux__
+    useSplice = true;
+    for (auto& direction : directions) {
+      if (pipe2(direction.pipeFileDescriptors, O_NONBLOCK | O_CLOEXEC) == -1) {
+        DisableSplice();
+        break;
+      }
+
+      fcntl(direction.pipeFileDescriptors[1], F_SETPIPE_SZ, (int) chunkSize);
+    }
+#endif
+
+    if (!useSplice) {
+      DisableSplice();
+    }
+  }
+
+  Passthrough::~Passthrough() {
+    for (auto& direction : directions) {
+      if (direction.pipeFileDescriptors[0] != -1) {
+        close(direction.pipeFileDescriptors[0]);
+        close(direction.pipeFileDescriptors[1]);
+      }
+
+      delete[] direction.buffer;
+    }
+  }
+
+  Errorable<Passthrough*> Passthrough::NewPassthrough(Connection* first, Connection* second, size_t chunk_size) {
+    auto firstReadWriteCloser = dynamic_cast<UnixReadWriteCloser*>(first->GetReadWriteCloser());
+    auto secondReadWriteCloser = dynamic_cast<UnixReadWriteCloser*>(second->GetReadWriteCloser());
+    if (!firstReadWriteCloser || !secondReadWriteCloser || first == second || chunk_size == 0) {
+      return InvalidPassthroughErrorable(0);
+    }
+
+    // Only untransformed bytes can be handed over, so switching has to wait until the pipelines consumed what they buffered.
+    if (first->HasPipelineInput() || second->HasPipelineInput()) {
+      return InvalidPassthroughErrorable(1);
+    }
+
+    // Whatever the handlers haven't consumed yet belongs to the peer now.
+    first->ForwardUnreadBytes(second);
+    second->ForwardUnreadBytes(first);
+
+    return SuccessErrorable<Passthrough*>(new Passthrough(
+      first, firstReadWriteCloser->GetFileDescriptor(), second, secondReadWriteCloser->GetFileDescriptor(), chunk_size));
+  }
+
+  void Passthrough::DisableSplice() {
+    useSplice = false;
+    for (auto& direction : directions) {
+      if (direction.pipeFileDescriptors[0] != -1) {
+        close(direction.pipeFileDescriptors[0]);
+        close(direction.pipeFileDescriptors[1]);
+        direction.pipeFileDescriptors[0] = -1;
+        direction.pipeFileDescriptors[1] = -1;
+      }
+
+      if (!direction.buffer) {
+        direction.buffer = new uint8_t[chunkSize];
+      }
+    }
+  }
+
+  Passthrough::Direction& Passthrough::GetDirectionFrom(Connection* source) {
+    return directions[0].source == source ? directions[0] : directions[1];
+  }
+
+  Passthrough::Direction& Passthrough::GetDirectionTo(Connection* target) {
+    return directions[0].target == target ? directions[0] : directions[1];
+  }
+
+  Connection* Passthrough::GetPeer(Connection* connection) const {
+    return directions[0].source == connection ? directions[0].target : directions[0].source;
+  }
+
+  Errorable<bool> Passthrough::Drain(Direction& direction) {
+    if (direction.target->GetPendingWriteBytes() != 0) {
+      Errorable<ssize_t> flushErrorable = direction.target->Flush();
+      if (direction.target->GetPendingWriteBytes() != 0) {
+        if (!flushErrorable.IsSuccess() && errno != EAGAIN) {
+          return ErrnoErrorable<bool>(false);
+        }
+
+        return SuccessErrorable<bool>(false);
+      }
+    }
+
+    while (direction.pendingBytes != 0) {
+      ssize_t bytesWritten;
+#ifdef __linux__
+      if (useSplice) {
+        bytesWritten = splice(direction.pipeFileDescriptors[0], nullptr, direction.targetFileDescriptor, nullptr, direction.pendingBytes,
+          SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      } else
+#endif
+      {
+        bytesWritten = send(direction.targetFileDescriptor, direction.buffer + direction.bufferOffset, direction.pendingBytes, MSG_NOSIGNAL);
+      }
+
+      if (bytesWritten == -1) {
+        if (errno == EAGAIN) {
+          return SuccessErrorable<bool>(false);
+        }
+
+        return ErrnoErrorable<bool>(false);
+      }
+
+      direction.pendingBytes -= bytesWritten;
+      direction.bufferOffset += bytesWritten;
+      forwardedBytes += bytesWritten;
+    }
+
+    direction.bufferOffset = 0;
+    return SuccessErrorable<bool>(true);
+  }
+
+  ssize_t Passthrough::Fill(Direction& direction) {
+    ssize_t bytesRead;
+#ifdef __linux__
+    if (useSplice) {
+      bytesRead = splice(direction.sourceFileDescriptor, nullptr, direction.pipeFileDescriptors[1], nullptr, chunkSize, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if (bytesRead != -1 || errno != EINVAL || directions[0].pendingBytes != 0 || directions[1].pendingBytes != 0) {
+        if (bytesRead > 0) {
+          direction.pendingBytes = bytesRead;
+        }
+
+        return bytesRead;
+      }
+
+      DisableSplice();
+    }
+#endif
+
+    bytesRead = read(direction.sourceFileDescriptor, direction.buffer, chunkSize);
+    if (bytesRead > 0) {
+      direction.pendingBytes = bytesRead;
+    }
+
+    return bytesRead;
+  }
+
+  PassthroughResult Passthrough::Forward(Direction& direction, size_t budget) {
+    size_t bytesRead = 0;
+
+    while (true) {
+      Errorable<bool> drainErrorable = Drain(direction);
+      if (!drainErrorable.IsSuccess()) {
+        return PassthroughResult::FAILED;
+      }
+
+      // The target is full: stop reading the source until EPOLLOUT reports it writable again.
+      if (!drainErrorable.GetValue()) {
+        return PassthroughResult::DRAINED;
+      }
+
+      if (direction.sourceFinished) {
+        if (!direction.targetShutdown) {
+          shutdown(direction.targetFileDescriptor, SHUT_WR);
+          direction.targetShutdown = true;
+        }
+
+        if (directions[0].targetShutdown && directions[1].targetShutdown) {
+          return PassthroughResult::FINISHED;
+        }
+
+        return PassthroughResult::DRAINED;
+      }
+
+      if (budget != 0 && bytesRead >= budget) {
+        return PassthroughResult::BUDGET_EXHAUSTED;
+      }
+
+      ssize_t filledBytes = Fill(direction);
+      if (filledBytes > 0) {
+        bytesRead += filledBytes;
+      } else if (filledBytes == 0) {
+        direction.sourceFinished = true;
+      } else if (errno == EAGAIN) {
+        return PassthroughResult::DRAINED;
+      } else {
+        return PassthroughResult::FAILED;
+      }
+    }
+  }
+
+  PassthroughResult Passthrough::OnReadable(Connection* source, size_t budget) {
+    return Forward(GetDirectionFrom(source), budget);
+  }
+
+  PassthroughResult Passthrough::OnWritable(Connection* target, size_t budget) {
+    return Forward(GetDirectionTo(target), budget);
+  }
+
+  bool Passthrough::IsUsingSplice() const {
+    return useSplice;
+  }
+
+  uint64_t Passthrough::GetForwardedBytes() const {
+    return forwardedBytes;
+  }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../Connection.hpp"
+
+namespace Ship {
+  class Passthrough;
+
+  CreateInvalidArgumentErrorable(InvalidPassthroughErrorable, Passthrough*, "Connections can't be switched to passthrough mode");
+
+  enum class PassthroughResult {
+    DRAINED,
+    BUDGET_EXHAUSTED,
+    FINISHED,
+    FAILED
+  };
+
+  // Forwards raw bytes between two connections, bypassing their pipes and handlers.
+  // Linux moves the bytes kernel-side with splice, everything else (or sockets splice refuses) goes through a plain read/write loop.
+  class Passthrough {
+   private:
+    struct Direction {
+      Connection* source;
+      Connection* target;
+      int sourceFileDescriptor;
+      int targetFileDescriptor;
+      int pipeFileDescriptors[2];
+      uint8_t* buffer;
+      size_t bufferOffset;
+      size_t pendingBytes;
+      bool sourceFinished;
+      bool targetShutdown;
+    };
+
+    Direction directions[2];
+    size_t chunkSize;
+    bool useSplice;
+    uint64_t forwardedBytes = 0;
+
+    Passthrough(Connection* first, int first_file_descriptor, Connection* second, int second_file_descriptor, size_t chunk_size);
+
+    Direction& GetDirectionFrom(Connection* source);
+    Direction& GetDirectionTo(Connection* target);
+    void DisableSplice();
+    Errorable<bool> Drain(Direction& direction);
+    ssize_t Fill(Direction& direction);
+    PassthroughResult Forward(Direction& direction, size_t budget);
+
+   public:
+    static Errorable<Passthrough*> NewPassthrough(Connection* first, Connection* second, size_t chunk_size);
+
+    ~Passthrough();
+
+    [[nodiscard]] Connection* GetPeer(Connection* connection) const;
+
+    PassthroughResult OnReadable(Connection* source, size_t budget);
+    PassthroughResult OnWritable(Connection* target, size_t budget);
+
+    [[nodiscard]] bool IsUsingSplice() const;
+    [[nodiscard]] uint64_t GetForwardedBytes() const;
+  };
+}
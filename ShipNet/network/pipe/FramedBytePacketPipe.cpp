@@ -16,12 +16,23 @@ namespace Ship {
         }
 
         nextReadFrameLength = frameLength;
+        // The length prefix is consumed now, only the bytes behind it belong to the frame.
+        readableBytes = in->GetReadableBytes();
       } else if (nextReadFrameLengthErrorable.GetTypeOrdinal() != IncompleteVarIntErrorable::TYPE_ORDINAL) {
         return InvalidFrameErrorable(frameLength);
       }
     }
 
     if (nextReadFrameLength != 0 && readableBytes >= nextReadFrameLength) {
+      if (forwardFilter) {
+        Errorable<uint32_t> ordinal = GetPacketOrdinal(in, nextReadFrameLength);
+        if (ordinal.IsSuccess() && !forwardFilter->Test(ordinal.GetValue())) {
+          uint32_t frameLength = nextReadFrameLength;
+          nextReadFrameLength = 0;
+          return ForwardedFrameErrorable(frameLength);
+        }
+      }
+
       Errorable<PacketHolder> packet = ReadPacket(in, nextReadFrameLength);
       nextReadFrameLength = 0;
       return packet;
@@ -29,4 +40,8 @@ namespace Ship {
 
     return IncompleteFrameErrorable(readableBytes);
   }
+
+  void FramedBytePacketPipe::SetForwardFilter(const OrdinalBitmap* filter) {
+    forwardFilter = filter;
+  }
 }
\ No newline at end of file
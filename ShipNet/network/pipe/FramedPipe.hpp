@@ -7,6 +7,8 @@ namespace Ship {
   CreateInvalidArgumentErrorable(InvalidByteFrameErrorable, size_t, "An exception occurred while decoding frame");
   CreateInvalidArgumentErrorable(IncompleteFrameErrorable, PacketHolder, "ByteBuffer doesn't contain enough data to read frame correctly");
   CreateInvalidArgumentErrorable(InvalidFrameErrorable, PacketHolder, "An exception occurred while decoding frame");
+  CreateInvalidArgumentErrorable(ForwardedFrameErrorable, PacketHolder, "Frame was left undecoded for raw forwarding, frame size");
+  CreateInvalidArgumentErrorable(UnknownFrameOrdinalErrorable, uint32_t, "Packet ordinal can not be determined without decoding the frame");
 
   class FramedByteBytePipe : public ByteBytePipe {
    private:
@@ -30,13 +32,20 @@ namespace Ship {
    private:
     uint32_t nextReadFrameLength = 0;
     uint32_t maxReadSize;
+    const OrdinalBitmap* forwardFilter = nullptr;
 
    public:
     explicit FramedBytePacketPipe(uint32_t max_read_size) : BytePacketPipe(), maxReadSize(max_read_size) {
     }
 
     Errorable<PacketHolder> Read(ByteBuffer* in) override;
+    void SetForwardFilter(const OrdinalBitmap* filter) override;
 
     virtual Errorable<PacketHolder> ReadPacket(ByteBuffer* in, uint32_t frame_size) = 0;
+
+    // Must not consume anything from the buffer, usually peeks the leading packet id and maps it through the registry.
+    virtual Errorable<uint32_t> GetPacketOrdinal(ByteBuffer* in, uint32_t frame_size) {
+      return UnknownFrameOrdinalErrorable(frame_size);
+    }
   };
 }
@@ -2,6 +2,7 @@
 
 #include "../../protocol/Protocol.hpp"
 #include "../../protocol/packet/Packet.hpp"
+#include "../../utils/ordinal/OrdinalBitmap.hpp"
 
 namespace Ship {
   class ByteBytePipe {
@@ -36,6 +37,16 @@ namespace Ship {
     virtual Errorable<size_t> Write(ByteBuffer* in) {
       return SuccessErrorable<size_t>(0);
     };
+
+    virtual bool ShouldOffload(ByteBuffer* in) {
+      return false;
+    }
+
+    // Runs on a WorkerPool thread when ShouldOffload returned true, so it must not touch state shared with Read/Write.
+    virtual Errorable<size_t> WriteOffloaded(ByteBuffer* in, ByteBuffer* out) {
+      return SuccessErrorable<size_t>(0);
+    }
+
     [[nodiscard]] virtual uint32_t GetOrdinal() const = 0;
   };
 
@@ -47,5 +58,9 @@ namespace Ship {
 
     virtual Errorable<PacketHolder> Read(ByteBuffer* in) = 0;
     virtual Errorable<bool> Write(ByteBuffer* out, const Packet& in) = 0;
+
+    // Frames of packets that are not in the filter may be left undecoded for raw forwarding, nullptr decodes everything.
+    virtual void SetForwardFilter(const OrdinalBitmap* filter) {
+    }
   };
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "../../protocol/Protocol.hpp"
 #include "./ReadWriteCloser.hpp"
+#include <atomic>
+#include <deque>
 
 namespace Ship {
 
@@ -17,11 +19,47 @@ namespace Ship {
     virtual void Close() {};
   };
 
+  class ZeroCopyStats {
+   public:
+    uint64_t zeroCopyBytes = 0;
+    uint64_t copiedBytes = 0;
+    uint64_t completions = 0;
+    // Completed sends the kernel still had to copy, loopback and devices without scatter-gather do that.
+    uint64_t kernelCopiedCompletions = 0;
+    // Segments the kernel might still read when their socket got deleted, they are never reused.
+    uint64_t abandonedSegments = 0;
+  };
+
+  class ZeroCopySend {
+   public:
+    uint32_t id;
+    // Set once the reader moved past the segment, entries of copied writes finishing a pinned segment are completed right away.
+    const uint8_t* segment;
+    size_t capacity;
+    bool completed;
+  };
+
   class UnixReadWriteCloser : public ReadWriteCloser {
    private:
+    // -1 once closed, Close leaves it open while zero-copy sends are in flight.
     int socketFileDescriptor;
     bool closed = false;
+    size_t zeroCopyThreshold = 0;
+    uint32_t nextZeroCopyID = 0;
+    // Front segment of the writer buffer a zero-copy send only partially covered, the buffer has to outlive Close.
+    const uint8_t* pinnedSegment = nullptr;
+    ByteBufferImpl* pinnedBuffer = nullptr;
+    std::deque<ZeroCopySend> zeroCopySends;
+
+    static std::atomic<uint64_t> zeroCopyBytes;
+    static std::atomic<uint64_t> copiedBytes;
+    static std::atomic<uint64_t> zeroCopyCompletions;
+    static std::atomic<uint64_t> kernelCopiedCompletions;
+    static std::atomic<uint64_t> abandonedSegments;
+
     inline void unixClose();
+    void SkipWrittenBytes(ByteBuffer* buffer, ByteBufferImpl* segments, size_t written, size_t chunk_size, bool zero_copy);
+    void ReleaseCompletedSends();
 
    public:
     explicit UnixReadWriteCloser(int socket_file_descriptor);
@@ -30,6 +68,20 @@ namespace Ship {
     Errorable<ssize_t> Write(ByteBuffer* buffer) override;
     Errorable<ssize_t> Read(uint8_t* buffer, size_t buffer_size) override;
     void Close() override;
+
+    [[nodiscard]] int GetFileDescriptor() const;
+    [[nodiscard]] bool IsClosed() const;
+
+    // Sets SO_ZEROCOPY, afterwards full segments of flushes of at least the threshold are sent without copying and stay out of the
+    // SegmentPool until ReadZeroCopyCompletions sees them completed. False if the platform or socket doesn't support it.
+    bool EnableZeroCopy(size_t threshold);
+    [[nodiscard]] bool IsZeroCopyEnabled() const;
+    // Drains the completion notifications from the socket error queue, true if there were any. Close keeps the socket open while
+    // sends are in flight, the owner keeps reading completions until none are pending and then deletes it. Deleting it earlier
+    // leaks the segments of the remaining sends.
+    bool ReadZeroCopyCompletions();
+    [[nodiscard]] size_t GetPendingZeroCopySends() const;
+    [[nodiscard]] static ZeroCopyStats GetZeroCopyStats();
   };
 
 }
\ No newline at end of file
@@ -1,8 +1,20 @@
 #include "../../utils/thread/EventLoop.hpp"
 #include "ReadWriteCloser.hpp"
+#include <sys/socket.h>
 #include <unistd.h>
 
+#ifdef __linux__
+  #include <linux/errqueue.h>
+  #include <netinet/in.h>
+#endif
+
 namespace Ship {
+  std::atomic<uint64_t> UnixReadWriteCloser::zeroCopyBytes {0};
+  std::atomic<uint64_t> UnixReadWriteCloser::copiedBytes {0};
+  std::atomic<uint64_t> UnixReadWriteCloser::zeroCopyCompletions {0};
+  std::atomic<uint64_t> UnixReadWriteCloser::kernelCopiedCompletions {0};
+  std::atomic<uint64_t> UnixReadWriteCloser::abandonedSegments {0};
+
   UnixReadWriteCloser::UnixReadWriteCloser(int socket_file_descriptor) : socketFileDescriptor(socket_file_descriptor) {
   }
 
@@ -12,9 +24,28 @@ namespace Ship {
       return SuccessErrorable<ssize_t>(totalBytesWritten);
     }
 
+    ByteBufferImpl* segments = zeroCopyThreshold != 0 ? dynamic_cast<ByteBufferImpl*>(buffer) : nullptr;
+    bool zeroCopy = segments && buffer->GetReadableBytes() >= zeroCopyThreshold;
+
     size_t singleCapacity = buffer->GetSingleCapacity();
     while (buffer->GetReadableBytes() >= singleCapacity - buffer->GetReaderIndex()) {
-      ssize_t bytesWritten = write(socketFileDescriptor, buffer->GetDirectReadAddress(), singleCapacity - buffer->GetReaderIndex());
+      size_t chunkSize = singleCapacity - buffer->GetReaderIndex();
+      ssize_t bytesWritten;
+#ifdef MSG_ZEROCOPY
+      if (zeroCopy) {
+        bytesWritten = send(socketFileDescriptor, buffer->GetDirectReadAddress(), chunkSize, MSG_ZEROCOPY);
+        if (bytesWritten == -1 && errno == ENOBUFS) {
+          // Out of socket option memory for notifications, the rest of the flush gets copied.
+          zeroCopy = false;
+          continue;
+        }
+      } else {
+        bytesWritten = write(socketFileDescriptor, buffer->GetDirectReadAddress(), chunkSize);
+      }
+#else
+      bytesWritten = write(socketFileDescriptor, buffer->GetDirectReadAddress(), chunkSize);
+#endif
+
       if (bytesWritten == -1) {
         if (errno == ECONNRESET) {
           Close();
@@ -24,7 +55,7 @@ namespace Ship {
         return ErrnoErrorable<ssize_t>({});
       }
 
-      buffer->SkipReadBytes(bytesWritten);
+      SkipWrittenBytes(buffer, segments, bytesWritten, chunkSize, zeroCopy);
       totalBytesWritten += bytesWritten;
     }
 
@@ -39,6 +70,10 @@ namespace Ship {
         return ErrnoErrorable<ssize_t>({});
       }
 
+      if (segments) {
+        copiedBytes.fetch_add(bytesWritten, std::memory_order_relaxed);
+      }
+
       buffer->SkipReadBytes(bytesWritten);
       totalBytesWritten += bytesWritten;
     }
@@ -46,6 +81,127 @@ namespace Ship {
     return SuccessErrorable<ssize_t>(totalBytesWritten);
   }
 
+  void UnixReadWriteCloser::SkipWrittenBytes(ByteBuffer* buffer, ByteBufferImpl* segments, size_t written, size_t chunk_size, bool zero_copy) {
+    if (!segments) {
+      buffer->SkipReadBytes(written);
+      return;
+    }
+
+    const uint8_t* segment = buffer->GetDirectReadAddress() - buffer->GetReaderIndex();
+    if (zero_copy) {
+      zeroCopySends.push_back({nextZeroCopyID++, nullptr, 0, false});
+      zeroCopyBytes.fetch_add(written, std::memory_order_relaxed);
+      pinnedSegment = segment;
+      pinnedBuffer = segments;
+    } else {
+      copiedBytes.fetch_add(written, std::memory_order_relaxed);
+    }
+
+    if (segment != pinnedSegment || written != chunk_size) {
+      buffer->SkipReadBytes(written);
+      return;
+    }
+
+    // Segments leave the pool cycle in send order and come back only after every earlier send completed.
+    size_t capacity = buffer->GetSingleCapacity();
+    if (zero_copy) {
+      zeroCopySends.back().segment = segments->DetachReadSegment();
+      zeroCopySends.back().capacity = capacity;
+    } else {
+      zeroCopySends.push_back({0, segments->DetachReadSegment(), capacity, true});
+    }
+
+    pinnedSegment = nullptr;
+  }
+
+  bool UnixReadWriteCloser::EnableZeroCopy(size_t threshold) {
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+    int enabled = 1;
+    if (setsockopt(socketFileDescriptor, SOL_SOCKET, SO_ZEROCOPY, &enabled, sizeof(int)) == -1) {
+      return false;
+    }
+
+    zeroCopyThreshold = threshold;
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool UnixReadWriteCloser::IsZeroCopyEnabled() const {
+    return zeroCopyThreshold != 0;
+  }
+
+  bool UnixReadWriteCloser::ReadZeroCopyCompletions() {
+    bool completed = false;
+#if defined(__linux__) && defined(SO_EE_ORIGIN_ZEROCOPY)
+    while (true) {
+      uint8_t control[128];
+      msghdr message {};
+      message.msg_control = control;
+      message.msg_controllen = sizeof(control);
+      if (recvmsg(socketFileDescriptor, &message, MSG_ERRQUEUE) == -1) {
+        break;
+      }
+
+      for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+        if (!(header->cmsg_level == SOL_IP && header->cmsg_type == IP_RECVERR) && !(header->cmsg_level == SOL_IPV6 && header->cmsg_type == IPV6_RECVERR)) {
+          continue;
+        }
+
+        auto* error = (sock_extended_err*) CMSG_DATA(header);
+        if (error->ee_errno != 0 || error->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+          continue;
+        }
+
+        // Inclusive range of send ids, ids wrap around after 2^32 sends.
+        uint32_t first = error->ee_info;
+        uint32_t count = error->ee_data - first + 1;
+        for (auto& send : zeroCopySends) {
+          if (!send.completed && (uint32_t) (send.id - first) < count) {
+            send.completed = true;
+          }
+        }
+
+        zeroCopyCompletions.fetch_add(count, std::memory_order_relaxed);
+        if (error->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+          kernelCopiedCompletions.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        completed = true;
+      }
+    }
+
+    ReleaseCompletedSends();
+#endif
+    return completed;
+  }
+
+  void UnixReadWriteCloser::ReleaseCompletedSends() {
+    SegmentPool& pool = SegmentPool::Local();
+    while (!zeroCopySends.empty() && zeroCopySends.front().completed) {
+      if (zeroCopySends.front().segment) {
+        pool.Release(zeroCopySends.front().segment, zeroCopySends.front().capacity);
+      }
+
+      zeroCopySends.pop_front();
+    }
+  }
+
+  size_t UnixReadWriteCloser::GetPendingZeroCopySends() const {
+    return zeroCopySends.size();
+  }
+
+  ZeroCopyStats UnixReadWriteCloser::GetZeroCopyStats() {
+    ZeroCopyStats stats;
+    stats.zeroCopyBytes = zeroCopyBytes.load(std::memory_order_relaxed);
+    stats.copiedBytes = copiedBytes.load(std::memory_order_relaxed);
+    stats.completions = zeroCopyCompletions.load(std::memory_order_relaxed);
+    stats.kernelCopiedCompletions = kernelCopiedCompletions.load(std::memory_order_relaxed);
+    stats.abandonedSegments = abandonedSegments.load(std::memory_order_relaxed);
+    return stats;
+  }
+
   Errorable<ssize_t> UnixReadWriteCloser::Read(uint8_t* buffer, size_t buffer_size) {
     if (!closed) {
       ssize_t bytesRead = read(socketFileDescriptor, buffer, buffer_size);
@@ -61,16 +217,51 @@ namespace Ship {
 
   UnixReadWriteCloser::~UnixReadWriteCloser() {
     unixClose();
+    // The kernel can still transmit from these, reusing them could leak other data to the peer.
+    for (const auto& send : zeroCopySends) {
+      abandonedSegments.fetch_add(send.segment != nullptr, std::memory_order_relaxed);
+    }
+
+    zeroCopySends.clear();
+    if (socketFileDescriptor != -1) {
+      close(socketFileDescriptor);
+    }
   }
 
   void UnixReadWriteCloser::Close() {
     unixClose();
   }
 
+  int UnixReadWriteCloser::GetFileDescriptor() const {
+    return socketFileDescriptor;
+  }
+
+  bool UnixReadWriteCloser::IsClosed() const {
+    return closed;
+  }
+
   inline void UnixReadWriteCloser::unixClose() {
     if (!closed) {
       closed = true;
+      if (pinnedSegment) {
+        // The partially sent segment leaves the writer buffer with the latest send, the one that last read from it.
+        zeroCopySends.back().segment = pinnedBuffer->DetachReadSegment();
+        zeroCopySends.back().capacity = pinnedBuffer->GetSingleCapacity();
+        pinnedSegment = nullptr;
+      }
+
+      if (!zeroCopySends.empty()) {
+        ReadZeroCopyCompletions();
+      }
+
+      if (!zeroCopySends.empty()) {
+        // Completions of the remaining sends only arrive on an open socket, so the write side is shut down and the rest waits.
+        shutdown(socketFileDescriptor, SHUT_WR);
+        return;
+      }
+
       close(socketFileDescriptor);
+      socketFileDescriptor = -1;
     }
   }
 }
\ No newline at end of file
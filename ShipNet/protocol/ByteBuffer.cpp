@@ -1,5 +1,7 @@
 #include "../Ship.hpp"
+#include "../utils/text/Utf8.hpp"
 #include "Protocol.hpp"
+#include <algorithm>
 #include <cmath>
 
 namespace Ship {
@@ -15,9 +17,6 @@ namespace Ship {
   const uint32_t ByteBuffer::ANGLE_SIZE = BYTE_SIZE;
   const uint32_t ByteBuffer::UUID_SIZE = LONG_SIZE * 2;
 
-  thread_local uint8_t* byteBufferReadBuffer = new uint8_t[MAX_PACKET_SIZE];
-  thread_local uint8_t* byteBufferWriteBuffer = new uint8_t[MAX_PACKET_SIZE];
-
   ByteBuffer::~ByteBuffer() = default;
 
   uint32_t ByteBuffer::VarIntBytes(uint32_t input) {
@@ -148,6 +147,16 @@ namespace Ship {
     WriteBytes((uint8_t*) input.c_str(), input.size());
   }
 
+  Errorable<bool> ByteBuffer::WriteString(const std::string& input, uint32_t max_size) {
+    ProceedErrorable(units, uint32_t, Utf8::CountUtf16Units((const uint8_t*) input.data(), input.size()), InvalidStringWriteErrorable(input.size()))
+      if (units > max_size) {
+      return InvalidStringWriteErrorable(units);
+    }
+
+    WriteString(input);
+    return SuccessErrorable<bool>(true);
+  }
+
   void ByteBuffer::WriteByteArray(ByteBuffer* input) {
     WriteVarInt(input->GetReadableBytes());
     WriteBytes(input, input->GetReadableBytes());
@@ -214,6 +223,23 @@ namespace Ship {
     return InvalidVarIntErrorable(decodedVarInt);
   }
 
+  Errorable<uint32_t> ByteBuffer::PeekVarInt(size_t offset) const {
+    uint32_t decodedVarInt = 0;
+    for (uint32_t byteIndex = 0; byteIndex < 5; ++byteIndex) {
+      if (GetReadableBytes() <= offset + byteIndex) {
+        return IncompleteVarIntErrorable(GetReadableBytes());
+      }
+
+      uint8_t byte = PeekByteUnsafe(offset + byteIndex);
+      decodedVarInt |= (byte & 0x7F) << byteIndex * 7;
+      if ((byte & 0x80) == 0) {
+        return SuccessErrorable<uint32_t>(decodedVarInt);
+      }
+    }
+
+    return InvalidVarIntErrorable(decodedVarInt);
+  }
+
   Errorable<uint64_t> ByteBuffer::ReadLong() {
     if (GetReadableBytes() < 8) {
       return IncompleteLongErrorable(GetReadableBytes());
@@ -273,12 +299,22 @@ namespace Ship {
 
   Errorable<std::string> ByteBuffer::ReadString(uint32_t max_size) {
     ProceedErrorable(length, uint32_t, ReadVarInt(), InvalidStringSizeErrorable(-1))
-      if (length > max_size) {
+      // The limit is in UTF-16 units, each of them takes at most 3 bytes.
+      if (length > (uint64_t) max_size * 3) {
       return InvalidStringSizeErrorable(length);
     }
 
-    ProceedErrorable(bytes, uint8_t*, ReadBytes(length), InvalidStringSizeErrorable(length))
-      return SuccessErrorable<std::string>((const char*) bytes);
+    std::string string(length, '\0');
+    if (!ReadBytes((uint8_t*) string.data(), length).IsSuccess()) {
+      return InvalidStringSizeErrorable(length);
+    }
+
+    ProceedErrorable(units, uint32_t, Utf8::CountUtf16Units((const uint8_t*) string.data(), length), InvalidStringEncodingErrorable(length))
+      if (units > max_size) {
+      return InvalidStringSizeErrorable(units);
+    }
+
+    return SuccessErrorable<std::string>(std::move(string));
   }
 
   Errorable<ByteBuffer*> ByteBuffer::ReadByteArray() {
@@ -319,29 +355,25 @@ namespace Ship {
       PopBuffer();
     }
 
-    localReaderIndex = count;
+    localReaderIndex += count;
     TryRefreshReaderBuffer();
     return SuccessErrorable<size_t>(count);
   }
 
   size_t ByteBufferImpl::SkipWriteBytes(size_t count) {
+    TryRefreshWriterBuffer();
     readableBytes += count;
     while (count > singleCapacity - localWriterIndex) {
-      count -= singleCapacity;
+      count -= singleCapacity - localWriterIndex;
       AppendBuffer();
     }
 
-    localWriterIndex = count;
-    TryRefreshWriterBuffer();
+    localWriterIndex += count;
     return count;
   }
 
   ByteBufferImpl::ByteBufferImpl(size_t cap) {
     singleCapacity = cap;
-    auto* buffer = new uint8_t[singleCapacity];
-    currentReadBuffer = buffer;
-    currentWriteBuffer = buffer;
-    buffers.push_back(buffer);
   }
 
   ByteBufferImpl::ByteBufferImpl(uint8_t* buffer, size_t cap) {
@@ -367,6 +399,11 @@ namespace Ship {
     return currentReadBuffer[localReaderIndex++];
   }
 
+  uint8_t ByteBufferImpl::PeekByteUnsafe(size_t offset) const {
+    size_t position = localReaderIndex + offset;
+    return buffers[position / singleCapacity][position % singleCapacity];
+  }
+
   void ByteBufferImpl::WriteByte(uint8_t input) {
     TryRefreshWriterBuffer();
     ++readableBytes;
@@ -403,8 +440,19 @@ namespace Ship {
 
   void ByteBufferImpl::WriteBytesAndDelete(const uint8_t* input, size_t size) {
     if (localWriterIndex == 0 && size == singleCapacity) {
-      buffers.pop_back();
+      if (!buffers.empty()) {
+        SegmentPool::Local().Release(buffers.back(), singleCapacity);
+        buffers.pop_back();
+      }
+
+      currentWriteBuffer = (uint8_t*) input;
+      if (buffers.empty()) {
+        currentReadBuffer = currentWriteBuffer;
+      }
+
       buffers.push_back(input);
+      localWriterIndex = size;
+      readableBytes += size;
     } else {
       WriteBytes(input, size);
       delete[] input;
@@ -412,8 +460,46 @@ namespace Ship {
   }
 
   void ByteBufferImpl::WriteBytes(ByteBuffer* input, size_t size) {
-    input->ReadBytes(byteBufferWriteBuffer, size);
-    WriteBytes(byteBufferWriteBuffer, size);
+    auto* inputImpl = dynamic_cast<ByteBufferImpl*>(input);
+
+    while (size != 0) {
+      if (inputImpl && size >= singleCapacity && MoveSegmentFrom(inputImpl)) {
+        size -= singleCapacity;
+        continue;
+      }
+
+      size_t chunkSize = std::min(size, input->GetContiguousReadableBytes());
+      if (chunkSize == 0) {
+        return;
+      }
+
+      WriteBytes(input->GetDirectReadAddress(), chunkSize);
+      input->SkipReadBytes(chunkSize);
+      size -= chunkSize;
+    }
+  }
+
+  bool ByteBufferImpl::MoveSegmentFrom(ByteBufferImpl* input) {
+    if (input->singleCapacity != singleCapacity || input->localReaderIndex != 0 || input->buffers.size() < 2
+        || (!buffers.empty() && localWriterIndex != singleCapacity)) {
+      return false;
+    }
+
+    const uint8_t* segment = input->buffers.front();
+    input->buffers.pop_front();
+    input->currentReadBuffer = (uint8_t*) input->buffers.front();
+    input->readableBytes -= singleCapacity;
+
+    if (buffers.empty()) {
+      localReaderIndex = 0;
+      currentReadBuffer = (uint8_t*) segment;
+    }
+
+    buffers.push_back(segment);
+    currentWriteBuffer = (uint8_t*) segment;
+    localWriterIndex = singleCapacity;
+    readableBytes += singleCapacity;
+    return true;
   }
 
   Errorable<uint8_t*> ByteBufferImpl::ReadBytes(uint8_t* output, size_t size) {
@@ -454,15 +540,35 @@ namespace Ship {
   }
 
   void ByteBufferImpl::Release() {
+    SegmentPool& pool = SegmentPool::Local();
     while (!buffers.empty()) {
-      delete[] buffers.front();
+      pool.Release(buffers.front(), singleCapacity);
       buffers.pop_front();
     }
+
+    currentReadBuffer = nullptr;
+    currentWriteBuffer = nullptr;
+    localReaderIndex = 0;
+    localWriterIndex = 0;
+    readableBytes = 0;
+  }
+
+  bool ByteBufferImpl::ReleaseIfDrained() {
+    if (readableBytes != 0 || buffers.empty()) {
+      return false;
+    }
+
+    Release();
+    return true;
+  }
+
+  size_t ByteBufferImpl::GetResidentBytes() const {
+    return buffers.size() * singleCapacity;
   }
 
   void ByteBufferImpl::ResetReaderIndex() {
     localReaderIndex = 0;
-    readableBytes = (buffers.size() - 1) * singleCapacity + localWriterIndex;
+    readableBytes = buffers.empty() ? 0 : (buffers.size() - 1) * singleCapacity + localWriterIndex;
   }
 
   void ByteBufferImpl::ResetWriterIndex() {
@@ -474,6 +580,15 @@ namespace Ship {
     return readableBytes;
   }
 
+  size_t ByteBufferImpl::GetContiguousReadableBytes() {
+    if (readableBytes == 0) {
+      return 0;
+    }
+
+    TryRefreshReaderBuffer();
+    return std::min(readableBytes, singleCapacity - localReaderIndex);
+  }
+
   void ByteBufferImpl::TryRefreshReaderBuffer() {
     if (localReaderIndex >= singleCapacity) {
       PopBuffer();
@@ -481,22 +596,55 @@ namespace Ship {
   }
 
   void ByteBufferImpl::TryRefreshWriterBuffer() {
-    if (localWriterIndex >= singleCapacity) {
+    if (buffers.empty() || localWriterIndex >= singleCapacity) {
       AppendBuffer();
     }
   }
 
   void ByteBufferImpl::AppendBuffer() {
     localWriterIndex = 0;
-    currentWriteBuffer = new uint8_t[singleCapacity];
+    currentWriteBuffer = SegmentPool::Local().Acquire(singleCapacity);
+    if (buffers.empty()) {
+      localReaderIndex = 0;
+      currentReadBuffer = currentWriteBuffer;
+    }
+
     buffers.push_back(currentWriteBuffer);
   }
 
   void ByteBufferImpl::PopBuffer() {
     localReaderIndex = 0;
-    delete buffers.front();
+    SegmentPool::Local().Release(buffers.front(), singleCapacity);
     buffers.pop_front();
-    currentReadBuffer = (uint8_t*) buffers.front();
+
+    if (buffers.empty()) {
+      localWriterIndex = 0;
+      currentReadBuffer = nullptr;
+      currentWriteBuffer = nullptr;
+    } else {
+      currentReadBuffer = (uint8_t*) buffers.front();
+    }
+  }
+
+  const uint8_t* ByteBufferImpl::DetachReadSegment() {
+    if (buffers.empty() || (buffers.size() == 1 && localWriterIndex != singleCapacity)) {
+      return nullptr;
+    }
+
+    const uint8_t* segment = buffers.front();
+    readableBytes -= singleCapacity - localReaderIndex;
+    localReaderIndex = 0;
+    buffers.pop_front();
+
+    if (buffers.empty()) {
+      localWriterIndex = 0;
+      currentReadBuffer = nullptr;
+      currentWriteBuffer = nullptr;
+    } else {
+      currentReadBuffer = (uint8_t*) buffers.front();
+    }
+
+    return segment;
   }
 
   bool ByteBufferImpl::CanReadDirect(size_t read_size) const {
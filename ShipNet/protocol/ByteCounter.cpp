@@ -70,6 +70,10 @@ namespace Ship {
     return 0;
   }
 
+  uint8_t ByteCounter::PeekByteUnsafe(size_t offset) const {
+    return 0;
+  }
+
   Errorable<uint8_t *> ByteCounter::ReadBytes(uint8_t *output, size_t size) {
     return SuccessErrorable<uint8_t *>(nullptr);
   }
@@ -100,6 +104,10 @@ namespace Ship {
     return SIZE_MAX;
   }
 
+  size_t ByteCounter::GetContiguousReadableBytes() {
+    return 0;
+  }
+
   size_t ByteCounter::GetSingleCapacity() const {
     return SIZE_MAX;
   }
@@ -143,4 +151,12 @@ namespace Ship {
   size_t ByteCounter::SkipWriteBytes(size_t count) {
     return 0;
   }
+
+  bool ByteCounter::ReleaseIfDrained() {
+    return false;
+  }
+
+  size_t ByteCounter::GetResidentBytes() const {
+    return 0;
+  }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../utils/exception/Errorable.hpp"
+#include "SegmentPool.hpp"
 #include "data/uuid/UUID.hpp"
 #include <deque>
 #include <list>
@@ -14,7 +15,9 @@ namespace Ship {
    private:
     uint32_t ordinal;
     uint32_t protocolID;
-    std::string displayVersion;
+    const std::string* displayVersion;
+
+    static const std::string* InternDisplayVersion(std::string display_version);
 
    public:
     static const ProtocolVersion UNKNOWN;
@@ -74,13 +77,13 @@ namespace Ship {
    private:
     const ProtocolVersion minimumVersion;
     const ProtocolVersion maximumVersion;
-    const uint32_t minimumProtocolVersion;
-    const uint32_t maximumProtocolVersion;
     const uint32_t minimumOrdinal;
     const uint32_t maximumOrdinal;
 
-    ProtocolVersion* idToVersionMap;
-    ProtocolVersion* ordinalToVersionMap;
+    // Protocol ids may be huge and sparse, so they are looked up in a sorted array while ordinals stay a dense table.
+    std::vector<ProtocolVersion> ordinalToVersionMap;
+    std::vector<uint32_t> sortedProtocolIDs;
+    std::vector<uint32_t> sortedProtocolOrdinals;
 
    public:
     explicit ProtocolVersions(const std::list<ProtocolVersion>& versions);
@@ -113,6 +116,8 @@ namespace Ship {
     virtual void WriteDouble(double input);
     virtual void WriteFloat(float input);
     virtual void WriteString(const std::string& input);
+    // Rejects malformed UTF-8 and strings longer than max_size UTF-16 units, the length prefix stays in bytes.
+    Errorable<bool> WriteString(const std::string& input, uint32_t max_size);
     virtual void WriteByteArray(ByteBuffer* input);
     virtual void WriteAngle(float input);
 
@@ -137,6 +142,9 @@ namespace Ship {
     virtual Errorable<ByteBuffer*> ReadByteArray(uint32_t max_size);
     virtual Errorable<float> ReadAngle();
 
+    [[nodiscard]] virtual uint8_t PeekByteUnsafe(size_t offset) const = 0;
+    [[nodiscard]] virtual Errorable<uint32_t> PeekVarInt(size_t offset) const;
+
     friend ByteBuffer& operator<<(ByteBuffer& buffer, bool input);
     friend ByteBuffer& operator<<(ByteBuffer& buffer, uint8_t input);
     friend ByteBuffer& operator<<(ByteBuffer& buffer, uint16_t input);
@@ -159,6 +167,7 @@ namespace Ship {
     virtual void ResetWriterIndex() = 0;
     [[nodiscard]] virtual size_t GetWriterIndex() const = 0;
     [[nodiscard]] virtual size_t GetReadableBytes() const = 0;
+    virtual size_t GetContiguousReadableBytes() = 0;
     [[nodiscard]] virtual size_t GetSingleCapacity() const = 0;
     [[nodiscard]] virtual std::deque<const uint8_t*> GetDirectBuffers() const = 0;
     virtual void TryRefreshReaderBuffer() = 0;
@@ -167,6 +176,8 @@ namespace Ship {
     virtual void PopBuffer() = 0;
     virtual Errorable<size_t> SkipReadBytes(size_t count) = 0;
     virtual size_t SkipWriteBytes(size_t count) = 0;
+    virtual bool ReleaseIfDrained() = 0;
+    [[nodiscard]] virtual size_t GetResidentBytes() const = 0;
 
     [[nodiscard]] virtual bool CanReadDirect(size_t read_size) const = 0;
     virtual uint8_t* GetDirectReadAddress() = 0;
@@ -206,6 +217,8 @@ namespace Ship {
   CreateInvalidArgumentErrorable(IncompleteDoubleErrorable, double, "ByteBuffer doesn't contain enough data to read double correctly");
   CreateInvalidArgumentErrorable(IncompleteByteArrayErrorable, uint8_t*, "ByteBuffer doesn't contain enough data to read byte array correctly");
   CreateInvalidArgumentErrorable(InvalidStringSizeErrorable, std::string, "Invalid received string size");
+  CreateInvalidArgumentErrorable(InvalidStringEncodingErrorable, std::string, "Received string is not valid UTF-8, string size");
+  CreateInvalidArgumentErrorable(InvalidStringWriteErrorable, bool, "Tried to write malformed or too long string");
   CreateInvalidArgumentErrorable(InvalidByteArraySizeErrorable, ByteBuffer*, "Invalid received byte array size");
   CreateInvalidArgumentErrorable(IncompleteAngleErrorable, float, "ByteBuffer doesn't contain enough data to read angle correctly");
   CreateInvalidArgumentErrorable(InvalidReadSkipRequest, size_t, "Not enough readable bytes to skip them");
@@ -214,12 +227,14 @@ namespace Ship {
    private:
     std::deque<const uint8_t*> buffers;
     size_t singleCapacity;
-    uint8_t* currentReadBuffer;
-    uint8_t* currentWriteBuffer;
+    uint8_t* currentReadBuffer = nullptr;
+    uint8_t* currentWriteBuffer = nullptr;
     size_t localReaderIndex = 0;
     size_t localWriterIndex = 0;
     size_t readableBytes = 0;
 
+    bool MoveSegmentFrom(ByteBufferImpl* input);
+
    public:
     explicit ByteBufferImpl(size_t singleCapacity);
     ByteBufferImpl(uint8_t* buffer, size_t singleCapacity);
@@ -234,6 +249,7 @@ namespace Ship {
 
     uint8_t ReadByteUnsafe() override;
     Errorable<uint8_t*> ReadBytes(uint8_t* output, size_t size) override;
+    [[nodiscard]] uint8_t PeekByteUnsafe(size_t offset) const override;
 
     void Release() override;
     void ResetReaderIndex() override;
@@ -241,6 +257,7 @@ namespace Ship {
     void ResetWriterIndex() override;
     [[nodiscard]] size_t GetWriterIndex() const override;
     [[nodiscard]] size_t GetReadableBytes() const override;
+    size_t GetContiguousReadableBytes() override;
     [[nodiscard]] size_t GetSingleCapacity() const override;
     [[nodiscard]] std::deque<const uint8_t*> GetDirectBuffers() const override;
     void TryRefreshReaderBuffer() override;
@@ -249,6 +266,10 @@ namespace Ship {
     void PopBuffer() override;
     Errorable<size_t> SkipReadBytes(size_t count) override;
     size_t SkipWriteBytes(size_t count) override;
+    bool ReleaseIfDrained() override;
+    [[nodiscard]] size_t GetResidentBytes() const override;
+    // Skips the rest of the fully written front segment and hands it to the caller instead of the SegmentPool, nullptr if it isn't full yet.
+    const uint8_t* DetachReadSegment();
 
     [[nodiscard]] bool CanReadDirect(size_t read_size) const override;
     uint8_t* GetDirectReadAddress() override;
@@ -264,6 +285,8 @@ namespace Ship {
    public:
     ~ByteCounter() override = default;
 
+    using ByteBuffer::WriteString;
+
     void WriteByte(uint8_t input) override;
     void WriteBytes(const uint8_t* input, size_t size) override;
     void WriteBytes(ByteBuffer* buffer, size_t size) override;
@@ -285,6 +308,7 @@ namespace Ship {
 
     uint8_t ReadByteUnsafe() override;
     Errorable<uint8_t*> ReadBytes(uint8_t* output, size_t size) override;
+    [[nodiscard]] uint8_t PeekByteUnsafe(size_t offset) const override;
 
     void Release() override;
     void ResetReaderIndex() override;
@@ -292,6 +316,7 @@ namespace Ship {
     void ResetWriterIndex() override;
     [[nodiscard]] size_t GetWriterIndex() const override;
     [[nodiscard]] size_t GetReadableBytes() const override;
+    size_t GetContiguousReadableBytes() override;
     [[nodiscard]] size_t GetSingleCapacity() const override;
     [[nodiscard]] std::deque<const uint8_t*> GetDirectBuffers() const override;
     void TryRefreshReaderBuffer() override;
@@ -300,6 +325,8 @@ namespace Ship {
     void PopBuffer() override;
     Errorable<size_t> SkipReadBytes(size_t count) override;
     size_t SkipWriteBytes(size_t count) override;
+    bool ReleaseIfDrained() override;
+    [[nodiscard]] size_t GetResidentBytes() const override;
 
     [[nodiscard]] bool CanReadDirect(size_t read_size) const override;
     uint8_t* GetDirectReadAddress() override;
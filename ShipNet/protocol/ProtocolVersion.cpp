@@ -1,39 +1,64 @@
 #include "Protocol.hpp"
+#include <algorithm>
+#include <mutex>
+#include <unordered_set>
 #include <utility>
 
 namespace Ship {
-  ProtocolVersion::ProtocolVersion() : ordinal(UINT32_MAX), protocolID(UINT32_MAX), displayVersion("Unknown") {
+  ProtocolVersion::ProtocolVersion() : ordinal(UINT32_MAX), protocolID(UINT32_MAX), displayVersion(InternDisplayVersion("Unknown")) {
   }
 
   const ProtocolVersion ProtocolVersion::UNKNOWN = ProtocolVersion();
 
+  const std::string* ProtocolVersion::InternDisplayVersion(std::string display_version) {
+    static std::mutex internMutex;
+    static std::unordered_set<std::string> displayVersions;
+
+    std::lock_guard<std::mutex> lock(internMutex);
+    return &*displayVersions.insert(std::move(display_version)).first;
+  }
+
   ProtocolVersions::ProtocolVersions(const std::list<ProtocolVersion>& versions)
-    : minimumVersion(versions.front()), maximumVersion(versions.back()), minimumProtocolVersion(minimumVersion.GetProtocolID()),
-      maximumProtocolVersion(maximumVersion.GetProtocolID()), minimumOrdinal(minimumVersion.GetOrdinal()), maximumOrdinal(maximumVersion.GetOrdinal()),
-      idToVersionMap(new ProtocolVersion[maximumProtocolVersion + 1]), ordinalToVersionMap(new ProtocolVersion[maximumOrdinal + 1]) {
+    : minimumVersion(versions.front()), maximumVersion(versions.back()), minimumOrdinal(minimumVersion.GetOrdinal()),
+      maximumOrdinal(maximumVersion.GetOrdinal()), ordinalToVersionMap(maximumOrdinal + 1) {
+    std::vector<std::pair<uint32_t, uint32_t>> protocolIDs;
     for (const auto& version : versions) {
-      idToVersionMap[version.GetProtocolID()] = version;
       ordinalToVersionMap[version.GetOrdinal()] = version;
+      protocolIDs.emplace_back(version.GetProtocolID(), version.GetOrdinal());
+    }
+
+    std::sort(protocolIDs.begin(), protocolIDs.end());
+    for (const auto& protocolID : protocolIDs) {
+      sortedProtocolIDs.push_back(protocolID.first);
+      sortedProtocolOrdinals.push_back(protocolID.second);
     }
   }
 
   ProtocolVersion::ProtocolVersion(uint32_t ordinal, uint32_t protocol_id, std::string display_version)
-    : ordinal(ordinal), protocolID(protocol_id), displayVersion(std::move(display_version)) {
+    : ordinal(ordinal), protocolID(protocol_id), displayVersion(InternDisplayVersion(std::move(display_version))) {
   }
 
   const ProtocolVersion* ProtocolVersions::FromProtocolID(uint32_t protocol_id) const {
-    if (protocol_id < minimumProtocolVersion || protocol_id > maximumProtocolVersion) {
+    const uint32_t* base = sortedProtocolIDs.data();
+    size_t length = sortedProtocolIDs.size();
+    while (length > 1) {
+      size_t half = length / 2;
+      base = base[half] <= protocol_id ? base + half : base;
+      length -= half;
+    }
+
+    if (length == 0 || *base != protocol_id) {
       return &ProtocolVersion::UNKNOWN;
-    } else {
-      return idToVersionMap + protocol_id;
     }
+
+    return &ordinalToVersionMap[sortedProtocolOrdinals[base - sortedProtocolIDs.data()]];
   }
 
   const ProtocolVersion* ProtocolVersions::FromOrdinal(uint32_t ordinal) const {
     if (ordinal < minimumOrdinal || ordinal > maximumOrdinal) {
       return &ProtocolVersion::UNKNOWN;
     } else {
-      return ordinalToVersionMap + ordinal;
+      return &ordinalToVersionMap[ordinal];
     }
   }
 
@@ -54,6 +79,6 @@ namespace Ship {
   }
 
   const std::string& ProtocolVersion::GetDisplayVersion() const {
-    return displayVersion;
+    return *displayVersion;
   }
 }
@@ -0,0 +1,342 @@
+#include "SegmentPool.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <string>
+#include <sys/mman.h>
+
+namespace Ship {
+  const size_t SegmentPool::DEFAULT_MAX_CACHED_BYTES = 16 * 1024 * 1024;
+  const size_t SegmentPool::MAX_FREE_LISTS = 8;
+  const size_t SegmentPool::SLAB_SIZE = 2 * 1024 * 1024;
+
+  std::atomic<std::atomic<uintptr_t>*> SegmentPool::slabTable {nullptr};
+  size_t SegmentPool::slabTableShift = 0;
+  size_t SegmentPool::maxSlabs = 0;
+  std::atomic<size_t> SegmentPool::reservedSlabs {0};
+  std::atomic<uint64_t> SegmentPool::hugeTLBSlabs {0};
+  std::atomic<uint64_t> SegmentPool::advisedSlabs {0};
+
+  SegmentPool::SegmentPool(size_t max_cached_bytes) : maxCachedBytes(max_cached_bytes) {
+  }
+
+  SegmentPool::~SegmentPool() {
+    Shrink();
+    OrphanSlabSegments();
+  }
+
+  SegmentPool::Orphans& SegmentPool::GetOrphans() {
+    // Never destroyed, pools of threads that exit after the static destructors ran still hand their segments over.
+    static auto* orphans = new Orphans();
+    return *orphans;
+  }
+
+  void SegmentPool::UpdateOrphansEmpty(Orphans& orphans) {
+    bool empty = orphans.tails.empty() && std::all_of(orphans.freeLists.begin(), orphans.freeLists.end(), [](const FreeList& freeList) {
+      return freeList.segments.empty();
+    });
+    orphans.empty.store(empty, std::memory_order_relaxed);
+  }
+
+  void SegmentPool::OrphanSlabSegments() {
+    if (freeLists.empty() && slabCursor == slabEnd) {
+      return;
+    }
+
+    Orphans& orphans = GetOrphans();
+    std::lock_guard<std::mutex> lock(orphans.mutex);
+    for (auto& freeList : freeLists) {
+      FreeList* orphaned = nullptr;
+      for (auto& orphanedFreeList : orphans.freeLists) {
+        if (orphanedFreeList.capacity == freeList.capacity) {
+          orphaned = &orphanedFreeList;
+          break;
+        }
+      }
+
+      if (!orphaned) {
+        orphans.freeLists.push_back({freeList.capacity, {}});
+        orphaned = &orphans.freeLists.back();
+      }
+
+      orphaned->segments.insert(orphaned->segments.end(), freeList.segments.begin(), freeList.segments.end());
+    }
+
+    if (slabCursor != slabEnd) {
+      orphans.tails.emplace_back(slabCursor, slabEnd);
+    }
+
+    freeLists.clear();
+    cachedBytes = 0;
+    slabCursor = nullptr;
+    slabEnd = nullptr;
+    UpdateOrphansEmpty(orphans);
+  }
+
+  uint8_t* SegmentPool::AdoptSegment(size_t capacity) {
+    Orphans& orphans = GetOrphans();
+    if (orphans.empty.load(std::memory_order_relaxed)) {
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(orphans.mutex);
+    for (auto& freeList : orphans.freeLists) {
+      if (freeList.capacity == capacity && !freeList.segments.empty()) {
+        uint8_t* segment = freeList.segments.back();
+        freeList.segments.pop_back();
+        UpdateOrphansEmpty(orphans);
+        return segment;
+      }
+    }
+
+    return nullptr;
+  }
+
+  bool SegmentPool::AdoptTail(size_t capacity) {
+    Orphans& orphans = GetOrphans();
+    if (orphans.empty.load(std::memory_order_relaxed)) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(orphans.mutex);
+    for (auto tail = orphans.tails.begin(); tail != orphans.tails.end(); ++tail) {
+      if ((size_t) (tail->second - tail->first) >= capacity) {
+        slabCursor = tail->first;
+        slabEnd = tail->second;
+        orphans.tails.erase(tail);
+        UpdateOrphansEmpty(orphans);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  SegmentPool& SegmentPool::Local() {
+    static thread_local SegmentPool pool(DEFAULT_MAX_CACHED_BYTES);
+    return pool;
+  }
+
+  bool SegmentPool::EnableHugePageSlabs(size_t arena_bytes) {
+    if (arena_bytes < SLAB_SIZE || slabTable.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    maxSlabs = arena_bytes / SLAB_SIZE;
+    size_t tableBits = 1;
+    while (((size_t) 1 << tableBits) < maxSlabs * 2) {
+      ++tableBits;
+    }
+
+    slabTableShift = 64 - tableBits;
+    slabTable.store(new std::atomic<uintptr_t>[(size_t) 1 << tableBits](), std::memory_order_release);
+    return true;
+  }
+
+  static size_t HashSlab(uintptr_t slab, size_t shift) {
+    return (size_t) (((slab / SegmentPool::SLAB_SIZE) * 0x9E3779B97F4A7C15ULL) >> shift);
+  }
+
+  void SegmentPool::InsertSlab(const uint8_t* slab) {
+    std::atomic<uintptr_t>* table = slabTable.load(std::memory_order_acquire);
+    size_t mask = ((size_t) 1 << (64 - slabTableShift)) - 1;
+    for (size_t index = HashSlab((uintptr_t) slab, slabTableShift);; index = (index + 1) & mask) {
+      uintptr_t expected = 0;
+      if (table[index].compare_exchange_strong(expected, (uintptr_t) slab, std::memory_order_release)) {
+        return;
+      }
+    }
+  }
+
+  bool SegmentPool::IsSlabSegment(const uint8_t* segment) {
+    std::atomic<uintptr_t>* table = slabTable.load(std::memory_order_acquire);
+    if (!table) {
+      return false;
+    }
+
+    uintptr_t slab = (uintptr_t) segment & ~(uintptr_t) (SLAB_SIZE - 1);
+    size_t mask = ((size_t) 1 << (64 - slabTableShift)) - 1;
+    for (size_t index = HashSlab(slab, slabTableShift);; index = (index + 1) & mask) {
+      uintptr_t current = table[index].load(std::memory_order_acquire);
+      if (current == slab) {
+        return true;
+      } else if (current == 0) {
+        return false;
+      }
+    }
+  }
+
+  uint8_t* SegmentPool::MapSlab() {
+    if (reservedSlabs.load(std::memory_order_relaxed) >= maxSlabs || reservedSlabs.fetch_add(1, std::memory_order_relaxed) >= maxSlabs) {
+      return nullptr;
+    }
+
+#ifdef MAP_HUGETLB
+    int hugeFlags = MAP_HUGETLB;
+  #ifdef MAP_HUGE_SHIFT
+    hugeFlags |= 21 << MAP_HUGE_SHIFT;
+  #endif
+
+    void* hugeSlab = mmap(nullptr, SLAB_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | hugeFlags, -1, 0);
+    if (hugeSlab != MAP_FAILED) {
+      InsertSlab((uint8_t*) hugeSlab);
+      hugeTLBSlabs.fetch_add(1, std::memory_order_relaxed);
+      return (uint8_t*) hugeSlab;
+    }
+#endif
+
+    // Without reserved huge pages, map twice the size and trim it to an aligned slab that transparent huge pages can back.
+    auto* mapping = (uint8_t*) mmap(nullptr, SLAB_SIZE * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+      return nullptr;
+    }
+
+    auto* slab = (uint8_t*) (((uintptr_t) mapping + SLAB_SIZE - 1) & ~(uintptr_t) (SLAB_SIZE - 1));
+    if (slab != mapping) {
+      munmap(mapping, slab - mapping);
+    }
+
+    munmap(slab + SLAB_SIZE, mapping + SLAB_SIZE * 2 - (slab + SLAB_SIZE));
+#ifdef MADV_HUGEPAGE
+    madvise(slab, SLAB_SIZE, MADV_HUGEPAGE);
+#endif
+
+    InsertSlab(slab);
+    advisedSlabs.fetch_add(1, std::memory_order_relaxed);
+    return slab;
+  }
+
+  uint8_t* SegmentPool::CarveSegment(size_t capacity) {
+    size_t stride = (capacity + 63) & ~(size_t) 63;
+    if ((size_t) (slabEnd - slabCursor) < capacity && !AdoptTail(capacity)) {
+      slabCursor = MapSlab();
+      if (!slabCursor) {
+        slabEnd = nullptr;
+        return nullptr;
+      }
+
+      slabEnd = slabCursor + SLAB_SIZE;
+    }
+
+    uint8_t* segment = slabCursor;
+    slabCursor += std::min(stride, (size_t) (slabEnd - slabCursor));
+    return segment;
+  }
+
+  SlabStats SegmentPool::GetSlabStats() {
+    SlabStats stats;
+    stats.hugeTLBSlabs = hugeTLBSlabs.load(std::memory_order_relaxed);
+    stats.advisedSlabs = advisedSlabs.load(std::memory_order_relaxed);
+    stats.slabs = stats.hugeTLBSlabs + stats.advisedSlabs;
+    if (stats.advisedSlabs == 0) {
+      return stats;
+    }
+
+    // Adjacent slabs may be merged into one mapping, which is counted when it starts at a slab.
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool inSlab = false;
+    while (std::getline(smaps, line)) {
+      size_t dash = line.find('-');
+      if (dash != std::string::npos && dash < line.find(' ') && std::isxdigit((unsigned char) line[0])) {
+        inSlab = IsSlabSegment((const uint8_t*) std::stoull(line.substr(0, dash), nullptr, 16));
+      } else if (inSlab && line.rfind("AnonHugePages:", 0) == 0) {
+        stats.transparentHugeBytes += std::stoull(line.substr(14)) * 1024;
+      }
+    }
+
+    return stats;
+  }
+
+  SegmentPool::FreeList* SegmentPool::FindFreeList(size_t capacity, bool unlimited) {
+    for (auto& freeList : freeLists) {
+      if (freeList.capacity == capacity) {
+        return &freeList;
+      }
+    }
+
+    if (unlimited || freeLists.size() < MAX_FREE_LISTS) {
+      freeLists.push_back({capacity, {}});
+      return &freeLists.back();
+    }
+
+    return nullptr;
+  }
+
+  uint8_t* SegmentPool::Acquire(size_t capacity) {
+    for (auto& freeList : freeLists) {
+      if (freeList.capacity == capacity && !freeList.segments.empty()) {
+        uint8_t* segment = freeList.segments.back();
+        freeList.segments.pop_back();
+        cachedBytes -= capacity;
+        return segment;
+      }
+    }
+
+    if (capacity <= SLAB_SIZE && slabTable.load(std::memory_order_relaxed)) {
+      uint8_t* segment = AdoptSegment(capacity);
+      if (segment) {
+        return segment;
+      }
+
+      segment = CarveSegment(capacity);
+      if (segment) {
+        return segment;
+      }
+    }
+
+    return new uint8_t[capacity];
+  }
+
+  void SegmentPool::Release(const uint8_t* segment, size_t capacity) {
+    // Slab segments can't be freed on their own, so they are cached regardless of the limit.
+    if (IsSlabSegment(segment)) {
+      FindFreeList(capacity, true)->segments.push_back((uint8_t*) segment);
+      cachedBytes += capacity;
+      return;
+    }
+
+    if (cachedBytes + capacity <= maxCachedBytes) {
+      FreeList* freeList = FindFreeList(capacity, false);
+      if (freeList) {
+        freeList->segments.push_back((uint8_t*) segment);
+        cachedBytes += capacity;
+        return;
+      }
+    }
+
+    delete[] segment;
+  }
+
+  void SegmentPool::Shrink() {
+    cachedBytes = 0;
+    for (auto& freeList : freeLists) {
+      auto kept = freeList.segments.begin();
+      for (uint8_t* segment : freeList.segments) {
+        if (IsSlabSegment(segment)) {
+          *kept++ = segment;
+        } else {
+          delete[] segment;
+        }
+      }
+
+      freeList.segments.erase(kept, freeList.segments.end());
+      cachedBytes += freeList.segments.size() * freeList.capacity;
+    }
+
+    freeLists.erase(std::remove_if(freeLists.begin(), freeLists.end(), [](const FreeList& freeList) {
+      return freeList.segments.empty();
+    }), freeLists.end());
+  }
+
+  void SegmentPool::SetMaxCachedBytes(size_t max_cached_bytes) {
+    maxCachedBytes = max_cached_bytes;
+    if (cachedBytes > maxCachedBytes) {
+      Shrink();
+    }
+  }
+
+  size_t SegmentPool::GetCachedBytes() const {
+    return cachedBytes;
+  }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Ship {
+  class SlabStats {
+   public:
+    uint64_t slabs = 0;
+    // Backed by MAP_HUGETLB pages, which are huge by construction.
+    uint64_t hugeTLBSlabs = 0;
+    // Fell back to regular pages with MADV_HUGEPAGE, whether they got huge depends on transparent huge pages.
+    uint64_t advisedSlabs = 0;
+    // Bytes of the arena the kernel actually maps with transparent huge pages, read from /proc/self/smaps.
+    uint64_t transparentHugeBytes = 0;
+  };
+
+  class SegmentPool {
+   private:
+    struct FreeList {
+      size_t capacity;
+      std::vector<uint8_t*> segments;
+    };
+
+    // Slab segments and carve tails of destroyed pools, so memory of exited threads is reused by the pools of other threads.
+    struct Orphans {
+      std::mutex mutex;
+      // Lets Acquire skip the lock while nothing is orphaned.
+      std::atomic<bool> empty {true};
+      std::vector<FreeList> freeLists;
+      std::vector<std::pair<uint8_t*, uint8_t*>> tails;
+    };
+
+    // Open addressed set of slab addresses, slabs are aligned to their size so a segment finds its slab by masking.
+    static std::atomic<std::atomic<uintptr_t>*> slabTable;
+    static size_t slabTableShift;
+    static size_t maxSlabs;
+    static std::atomic<size_t> reservedSlabs;
+    static std::atomic<uint64_t> hugeTLBSlabs;
+    static std::atomic<uint64_t> advisedSlabs;
+
+    std::vector<FreeList> freeLists;
+    size_t maxCachedBytes;
+    size_t cachedBytes = 0;
+    uint8_t* slabCursor = nullptr;
+    uint8_t* slabEnd = nullptr;
+
+    FreeList* FindFreeList(size_t capacity, bool unlimited);
+    uint8_t* CarveSegment(size_t capacity);
+    static Orphans& GetOrphans();
+    static void UpdateOrphansEmpty(Orphans& orphans);
+    void OrphanSlabSegments();
+    uint8_t* AdoptSegment(size_t capacity);
+    bool AdoptTail(size_t capacity);
+    static uint8_t* MapSlab();
+    static void InsertSlab(const uint8_t* slab);
+
+   public:
+    static const size_t DEFAULT_MAX_CACHED_BYTES;
+    static const size_t MAX_FREE_LISTS;
+    static const size_t SLAB_SIZE;
+
+    explicit SegmentPool(size_t max_cached_bytes);
+    ~SegmentPool();
+
+    // Every thread gets its own pool, so segments are recycled without locking.
+    static SegmentPool& Local();
+
+    // Lets every pool carve its segments from huge page slabs, up to arena_bytes in total. Call it once before the loops start.
+    // Slabs stay mapped for the lifetime of the process, segments carved from them are always kept by the pool that gets them back,
+    // a destroyed pool hands them and the rest of its slab over to the other pools.
+    static bool EnableHugePageSlabs(size_t arena_bytes);
+    [[nodiscard]] static bool IsSlabSegment(const uint8_t* segment);
+    [[nodiscard]] static SlabStats GetSlabStats();
+
+    uint8_t* Acquire(size_t capacity);
+    void Release(const uint8_t* segment, size_t capacity);
+    // Only frees heap segments, slab segments stay cached.
+    void Shrink();
+
+    void SetMaxCachedBytes(size_t max_cached_bytes);
+    [[nodiscard]] size_t GetCachedBytes() const;
+  };
+}
@@ -1,64 +1,128 @@
 #include "UUID.hpp"
+#include <algorithm>
+#include <array>
 
 namespace Ship {
-  Errorable<UUID> UUID::Instantiate(const std::string& uuid) {
-    std::string inputUUID = uuid;
+  static constexpr std::array<uint8_t, 256> HEX_DIGITS = [] {
+    // 0x10 marks everything that is not a hex digit, it survives OR-ing the digits of a UUID together.
+    std::array<uint8_t, 256> digits {};
+    for (size_t i = 0; i < digits.size(); ++i) {
+      digits[i] = 0x10;
+    }
 
-    if (uuid.size() == 36) {
-      std::string tempString;
-      tempString.reserve(32);
-      int cnt = 0;
+    for (uint8_t i = 0; i < 10; ++i) {
+      digits['0' + i] = i;
+    }
 
-      for (int i = 0; i < 8; ++i) {
-        tempString[cnt++] = uuid[i];
-      }
+    for (uint8_t i = 0; i < 6; ++i) {
+      digits['a' + i] = 10 + i;
+      digits['A' + i] = 10 + i;
+    }
 
-      for (int i = 8; i < 13; ++i) {
-        tempString[cnt++] = uuid[i];
-      }
+    return digits;
+  }();
 
-      for (int i = 13; i < 18; ++i) {
-        tempString[cnt++] = uuid[i];
-      }
+  static constexpr std::array<char, 512> HEX_PAIRS = [] {
+    std::array<char, 512> pairs {};
+    const char* alphabet = "0123456789abcdef";
+    for (size_t i = 0; i < 256; ++i) {
+      pairs[i * 2] = alphabet[i >> 4];
+      pairs[i * 2 + 1] = alphabet[i & 0xF];
+    }
 
-      for (int i = 18; i < 23; ++i) {
-        tempString[cnt++] = uuid[i];
-      }
+    return pairs;
+  }();
 
-      for (int i = 23; i < 36; ++i) {
-        tempString[cnt++] = uuid[i];
-      }
+  static inline uint64_t DecodeHex(const char* input, uint8_t& invalid) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < 16; ++i) {
+      uint8_t digit = HEX_DIGITS[(uint8_t) input[i]];
+      invalid |= digit;
+      value = value << 4 | (digit & 0xF);
+    }
 
-      inputUUID = tempString;
+    return value;
+  }
+
+  static inline void EncodeHex(uint64_t value, char* output, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+      const char* pair = &HEX_PAIRS[((value >> (bytes - i - 1) * 8) & 0xFF) * 2];
+      output[i * 2] = pair[0];
+      output[i * 2 + 1] = pair[1];
     }
+  }
+
+  Errorable<UUID> UUID::Instantiate(const std::string& uuid) {
+    return Instantiate(uuid.data(), uuid.size());
+  }
+
+  Errorable<UUID> UUID::Instantiate(const char* uuid, size_t size) {
+    char undashed[UNDASHED_STRING_SIZE];
+    const char* digits = uuid;
+    uint8_t invalid = 0;
 
-    if (inputUUID.size() == 32) {
-      const char* chars = inputUUID.c_str();
-      char* end;
-      uint64_t mostSignificant = strtoull(chars, &end, 16);
-      uint64_t leastSignificant = strtoull(end, nullptr, 16);
-      return SuccessErrorable<UUID>({mostSignificant, leastSignificant});
-    } else {
-      return InvalidUUIDSizeErrorable(inputUUID.size());
+    if (size == STRING_SIZE) {
+      // xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
+      invalid = uuid[8] == '-' && uuid[13] == '-' && uuid[18] == '-' && uuid[23] == '-' ? 0 : 0x10;
+      std::copy(uuid, uuid + 8, undashed);
+      std::copy(uuid + 9, uuid + 13, undashed + 8);
+      std::copy(uuid + 14, uuid + 18, undashed + 12);
+      std::copy(uuid + 19, uuid + 23, undashed + 16);
+      std::copy(uuid + 24, uuid + 36, undashed + 20);
+      digits = undashed;
+    } else if (size != UNDASHED_STRING_SIZE) {
+      return InvalidUUIDSizeErrorable(size);
     }
+
+    uint64_t mostSignificant = DecodeHex(digits, invalid);
+    uint64_t leastSignificant = DecodeHex(digits + 16, invalid);
+    if (invalid & 0xF0) {
+      return InvalidUUIDCharacterErrorable(size);
+    }
+
+    return SuccessErrorable<UUID>({mostSignificant, leastSignificant});
   }
 
   UUID::UUID(uint64_t mostSignificant, uint64_t leastSignificant) : mostSignificant(mostSignificant), leastSignificant(leastSignificant) {
   }
 
+  void UUID::WriteUndashedString(char* output) const {
+    EncodeHex(mostSignificant, output, 8);
+    EncodeHex(leastSignificant, output + 16, 8);
+  }
+
+  void UUID::WriteString(char* output) const {
+    EncodeHex(mostSignificant >> 32, output, 4);
+    output[8] = '-';
+    EncodeHex(mostSignificant >> 16, output + 9, 2);
+    output[13] = '-';
+    EncodeHex(mostSignificant, output + 14, 2);
+    output[18] = '-';
+    EncodeHex(leastSignificant >> 48, output + 19, 2);
+    output[23] = '-';
+    EncodeHex(leastSignificant, output + 24, 6);
+  }
+
   std::string UUID::ToUndashedString() const {
-    return std::to_string(mostSignificant) + std::to_string(leastSignificant);
+    std::string uuid(UNDASHED_STRING_SIZE, '\0');
+    WriteUndashedString(uuid.data());
+    return uuid;
   }
 
   std::string UUID::ToString() const {
-    std::string uuid = ToUndashedString();
-    uuid.insert(20, "-");
-    uuid.insert(16, "-");
-    uuid.insert(12, "-");
-    uuid.insert(8, "-");
+    std::string uuid(STRING_SIZE, '\0');
+    WriteString(uuid.data());
     return uuid;
   }
 
+  bool UUID::operator==(const UUID& other) const {
+    return mostSignificant == other.mostSignificant && leastSignificant == other.leastSignificant;
+  }
+
+  bool UUID::operator!=(const UUID& other) const {
+    return !(*this == other);
+  }
+
   uint64_t UUID::GetMostSignificant() const {
     return this->mostSignificant;
   }
@@ -66,4 +130,4 @@ namespace Ship {
   uint64_t UUID::GetLeastSignificant() const {
     return this->leastSignificant;
   }
-}
\ No newline at end of file
+}
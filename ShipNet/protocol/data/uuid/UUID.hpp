@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../../utils/exception/Errorable.hpp"
+#include <functional>
 #include <string>
 
 namespace Ship {
@@ -10,9 +11,14 @@ namespace Ship {
     uint64_t leastSignificant;
 
    public:
+    static constexpr size_t STRING_SIZE = 36;
+    static constexpr size_t UNDASHED_STRING_SIZE = 32;
+
     UUID() = default;
 
+    // Accepts both the dashed and the undashed form, hex digits may be of either case.
     static Errorable<UUID> Instantiate(const std::string& uuid);
+    static Errorable<UUID> Instantiate(const char* uuid, size_t size);
 
     UUID(uint64_t mostSignificant, uint64_t leastSignificant);
 
@@ -23,7 +29,26 @@ namespace Ship {
     [[nodiscard]] std::string ToUndashedString() const;
 
     [[nodiscard]] std::string ToString() const;
+
+    // Write exactly UNDASHED_STRING_SIZE and STRING_SIZE lowercase characters, without a terminating zero.
+    void WriteUndashedString(char* output) const;
+    void WriteString(char* output) const;
+
+    bool operator==(const UUID& other) const;
+    bool operator!=(const UUID& other) const;
   };
 
   CreateInvalidArgumentErrorable(InvalidUUIDSizeErrorable, UUID, "Invalid UUID size");
+  CreateInvalidArgumentErrorable(InvalidUUIDCharacterErrorable, UUID, "Invalid UUID character, UUID size");
 }
+
+template<>
+struct std::hash<Ship::UUID> {
+  size_t operator()(const Ship::UUID& uuid) const noexcept {
+    // Mixes both halves so that hash tables with power of two buckets don't depend on the UUID version bits only.
+    uint64_t hash = uuid.GetMostSignificant() * 0x9E3779B97F4A7C15ULL ^ uuid.GetLeastSignificant();
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+  }
+};
@@ -25,7 +25,7 @@ namespace Ship {
   }
 
   bool PacketHandler::HasCallback(uint32_t ordinal) const {
-    if (callbacks.size() >= GetOrdinal()) {
+    if (GetOrdinal() >= callbacks.size()) {
       return false;
     }
 
@@ -33,9 +33,22 @@ namespace Ship {
     return ordinal < localCallbacks.size() && localCallbacks[ordinal];
   }
 
+  void PacketHandler::CollectCallbackOrdinals(OrdinalBitmap& bitmap) const {
+    if (GetOrdinal() >= callbacks.size()) {
+      return;
+    }
+
+    const auto& localCallbacks = callbacks[GetOrdinal()];
+    for (uint32_t ordinal = 0; ordinal < localCallbacks.size(); ++ordinal) {
+      if (localCallbacks[ordinal]) {
+        bitmap.Set(ordinal);
+      }
+    }
+  }
+
   void PacketHandler::SetPointerCallback(
     uint32_t handler_ordinal, uint32_t packet_ordinal, std::function<Errorable<bool>(PacketHandler*, void*, const PacketHolder&)> callback) {
-    if (callbacks.size() >= handler_ordinal) {
+    if (handler_ordinal >= callbacks.size()) {
       callbacks.resize(handler_ordinal + 8);
     }
 
@@ -2,6 +2,7 @@
 
 #include "../Protocol.hpp"
 #include "../packet/Packet.hpp"
+#include "../../utils/ordinal/OrdinalBitmap.hpp"
 #include <functional>
 
 #define SetPacketCallback(handlerClass, packetClass, callback)                                                                                   \
@@ -52,8 +53,9 @@ namespace Ship {
    public:
     virtual ~PacketHandler() = default;
 
-    Errorable<bool> Handle(PacketHandler* handler_ptr, void* connection, const PacketHolder& packet);
-    bool HasCallback(uint32_t ordinal) const;
+    virtual Errorable<bool> Handle(PacketHandler* handler_ptr, void* connection, const PacketHolder& packet);
+    [[nodiscard]] virtual bool HasCallback(uint32_t ordinal) const;
+    virtual void CollectCallbackOrdinals(OrdinalBitmap& bitmap) const;
 
     [[nodiscard]] virtual uint32_t GetOrdinal() const = 0;
 
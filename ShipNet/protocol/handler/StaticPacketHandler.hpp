@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../packet/PacketList.hpp"
+#include "PacketHandler.hpp"
+#include <utility>
+
+namespace Ship {
+  class Connection;
+
+  // Dispatches through a table generated from List instead of the runtime callback registry. Derived handles a packet by
+  // declaring Errorable<bool> OnPacket(Connection* connection, const P& packet), packets without such overload are not handled.
+  // Packet ordinals are the runtime ones of List, see PacketList::GetOrdinal, so it can be mixed with runtime handlers.
+  template<typename Derived, typename List>
+  class StaticPacketHandler : public PacketHandler {
+   private:
+    using Callback = Errorable<bool> (*)(Derived*, Connection*, const PacketHolder&);
+
+    template<typename P, typename = void>
+    struct Handles : std::false_type {};
+
+    template<typename P>
+    struct Handles<P, std::void_t<decltype(std::declval<Derived&>().OnPacket(std::declval<Connection*>(), std::declval<const P&>()))>>
+      : std::true_type {};
+
+    template<typename P>
+    static Errorable<bool> Invoke(Derived* handler, Connection* connection, const PacketHolder& holder) {
+      ByteBuffer* buffer = holder.GetCurrentBuffer();
+      uint32_t oldReadableBytes = buffer->GetReadableBytes();
+      Errorable<P> pkt = P::Instantiate(holder);
+
+      if (!pkt.IsSuccess()) {
+        return (Errorable<bool>) CanNotReadPacketErrorable(holder.GetExpectedSize());
+      }
+
+      if (oldReadableBytes - buffer->GetReadableBytes() != holder.GetExpectedSize()) {
+        return (Errorable<bool>) InvalidPacketSizeErrorable(holder.GetExpectedSize());
+      }
+
+      return handler->OnPacket(connection, pkt.GetValue());
+    }
+
+    template<typename P>
+    static constexpr Callback CallbackFor() {
+      if constexpr (Handles<P>::value) {
+        return &Invoke<P>;
+      } else {
+        return nullptr;
+      }
+    }
+
+    template<size_t... Ordinals>
+    static constexpr std::array<Callback, List::SIZE> BuildCallbacks(std::index_sequence<Ordinals...>) {
+      return {CallbackFor<typename List::template At<Ordinals>>()...};
+    }
+
+    // Kept inside a function, so the table is only generated once Derived is complete.
+    static const std::array<Callback, List::SIZE>& GetCallbacks() {
+      static constexpr std::array<Callback, List::SIZE> callbacks = BuildCallbacks(std::make_index_sequence<List::SIZE>());
+      return callbacks;
+    }
+
+   public:
+    Errorable<bool> Handle(PacketHandler* handler_ptr, void* connection, const PacketHolder& packet) override {
+      // Ordinals below the base wrap around and fail the range check as well.
+      uint32_t ordinal = packet.GetOrdinal() - List::GetBaseOrdinal();
+      if (ordinal >= List::SIZE) {
+        return SuccessErrorable<bool>(false);
+      }
+
+      Callback callback = GetCallbacks()[ordinal];
+      if (callback) {
+        return callback((Derived*) handler_ptr, (Connection*) connection, packet);
+      } else {
+        return SuccessErrorable<bool>(false);
+      }
+    }
+
+    [[nodiscard]] bool HasCallback(uint32_t ordinal) const override {
+      uint32_t position = ordinal - List::GetBaseOrdinal();
+      return position < List::SIZE && GetCallbacks()[position];
+    }
+
+    void CollectCallbackOrdinals(OrdinalBitmap& bitmap) const override {
+      for (uint32_t position = 0; position < List::SIZE; ++position) {
+        if (GetCallbacks()[position]) {
+          bitmap.Set(List::GetBaseOrdinal() + position);
+        }
+      }
+    }
+  };
+}
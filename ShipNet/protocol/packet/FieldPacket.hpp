@@ -0,0 +1,453 @@
+#pragma once
+
+#include "Packet.hpp"
+#include <cstring>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Ship {
+  CreateInvalidArgumentErrorable(IncompleteFieldErrorable, bool, "ByteBuffer doesn't contain enough data to read packet field, readable bytes");
+  CreateInvalidArgumentErrorable(InvalidArrayLengthErrorable, bool, "Invalid array length");
+
+  // Field descriptors: FIXED_SIZE is non-zero for fixed-width fields, which additionally provide ReadUnsafe for callers
+  // that already checked the readable bytes. Fields with limits return an Errorable from Write and refuse values Read
+  // would reject, the others can't fail and return nothing.
+  template<typename T, uint32_t Size>
+  class FixedField {
+   public:
+    using Type = T;
+    static constexpr uint32_t FIXED_SIZE = Size;
+
+    static uint32_t GetSize(const T& value) {
+      return FIXED_SIZE;
+    }
+  };
+
+  class BooleanField : public FixedField<bool, 1> {
+   public:
+    static void Write(ByteBuffer* buffer, bool value) {
+      buffer->WriteBoolean(value);
+    }
+
+    static bool ReadUnsafe(ByteBuffer* buffer) {
+      return buffer->ReadByteUnsafe() != 0;
+    }
+  };
+
+  class ByteField : public FixedField<uint8_t, 1> {
+   public:
+    static void Write(ByteBuffer* buffer, uint8_t value) {
+      buffer->WriteByte(value);
+    }
+
+    static uint8_t ReadUnsafe(ByteBuffer* buffer) {
+      return buffer->ReadByteUnsafe();
+    }
+  };
+
+  class ShortField : public FixedField<uint16_t, 2> {
+   public:
+    static void Write(ByteBuffer* buffer, uint16_t value) {
+      buffer->WriteShort(value);
+    }
+
+    static uint16_t ReadUnsafe(ByteBuffer* buffer) {
+      uint16_t high = buffer->ReadByteUnsafe();
+      return high << 8 | buffer->ReadByteUnsafe();
+    }
+  };
+
+  class IntField : public FixedField<uint32_t, 4> {
+   public:
+    static void Write(ByteBuffer* buffer, uint32_t value) {
+      buffer->WriteInt(value);
+    }
+
+    static uint32_t ReadUnsafe(ByteBuffer* buffer) {
+      uint32_t value = 0;
+      for (uint32_t i = 0; i < 4; ++i) {
+        value = value << 8 | buffer->ReadByteUnsafe();
+      }
+
+      return value;
+    }
+  };
+
+  class LongField : public FixedField<uint64_t, 8> {
+   public:
+    static void Write(ByteBuffer* buffer, uint64_t value) {
+      buffer->WriteLong(value);
+    }
+
+    static uint64_t ReadUnsafe(ByteBuffer* buffer) {
+      uint64_t value = 0;
+      for (uint32_t i = 0; i < 8; ++i) {
+        value = value << 8 | buffer->ReadByteUnsafe();
+      }
+
+      return value;
+    }
+  };
+
+  class FloatField : public FixedField<float, 4> {
+   public:
+    static void Write(ByteBuffer* buffer, float value) {
+      buffer->WriteFloat(value);
+    }
+
+    static float ReadUnsafe(ByteBuffer* buffer) {
+      uint32_t bits = IntField::ReadUnsafe(buffer);
+      float value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+  };
+
+  class DoubleField : public FixedField<double, 8> {
+   public:
+    static void Write(ByteBuffer* buffer, double value) {
+      buffer->WriteDouble(value);
+    }
+
+    static double ReadUnsafe(ByteBuffer* buffer) {
+      uint64_t bits = LongField::ReadUnsafe(buffer);
+      double value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+  };
+
+  class UUIDField : public FixedField<UUID, 16> {
+   public:
+    static void Write(ByteBuffer* buffer, const UUID& value) {
+      buffer->WriteUUID(value);
+    }
+
+    static UUID ReadUnsafe(ByteBuffer* buffer) {
+      uint64_t mostSignificant = LongField::ReadUnsafe(buffer);
+      return {mostSignificant, LongField::ReadUnsafe(buffer)};
+    }
+  };
+
+  class VarIntField {
+   public:
+    using Type = uint32_t;
+    static constexpr uint32_t FIXED_SIZE = 0;
+
+    static uint32_t GetSize(uint32_t value) {
+      return ByteBuffer::VarIntBytes(value);
+    }
+
+    static void Write(ByteBuffer* buffer, uint32_t value) {
+      buffer->WriteVarInt(value);
+    }
+
+    static Errorable<uint32_t> Read(ByteBuffer* buffer) {
+      return buffer->ReadVarInt();
+    }
+  };
+
+  class VarLongField {
+   public:
+    using Type = uint64_t;
+    static constexpr uint32_t FIXED_SIZE = 0;
+
+    static uint32_t GetSize(uint64_t value) {
+      return ByteBuffer::VarLongBytes(value);
+    }
+
+    static void Write(ByteBuffer* buffer, uint64_t value) {
+      buffer->WriteVarLong(value);
+    }
+
+    static Errorable<uint64_t> Read(ByteBuffer* buffer) {
+      return buffer->ReadVarLong();
+    }
+  };
+
+  template<uint32_t MaxSize>
+  class StringField {
+   public:
+    using Type = std::string;
+    static constexpr uint32_t FIXED_SIZE = 0;
+
+    static uint32_t GetSize(const std::string& value) {
+      return ByteBuffer::StringBytes(value);
+    }
+
+    static Errorable<bool> Write(ByteBuffer* buffer, const std::string& value) {
+      return buffer->WriteString(value, MaxSize);
+    }
+
+    static Errorable<std::string> Read(ByteBuffer* buffer) {
+      return buffer->ReadString(MaxSize);
+    }
+  };
+
+  template<typename Field>
+  class OptionalField {
+   public:
+    using Type = std::optional<typename Field::Type>;
+    static constexpr uint32_t FIXED_SIZE = 0;
+
+    static uint32_t GetSize(const Type& value) {
+      return ByteBuffer::BOOLEAN_SIZE + (value ? Field::GetSize(*value) : 0);
+    }
+
+    static Errorable<bool> Write(ByteBuffer* buffer, const Type& value);
+
+    static Errorable<Type> Read(ByteBuffer* buffer);
+  };
+
+  template<typename Field, uint32_t MaxLength>
+  class ArrayField {
+   public:
+    using Type = std::vector<typename Field::Type>;
+    static constexpr uint32_t FIXED_SIZE = 0;
+
+    static uint32_t GetSize(const Type& value) {
+      if constexpr (Field::FIXED_SIZE != 0) {
+        return ByteBuffer::VarIntBytes(value.size()) + value.size() * Field::FIXED_SIZE;
+      } else {
+        uint32_t size = ByteBuffer::VarIntBytes(value.size());
+        for (const auto& element : value) {
+          size += Field::GetSize(element);
+        }
+
+        return size;
+      }
+    }
+
+    static Errorable<bool> Write(ByteBuffer* buffer, const Type& value);
+
+    static Errorable<Type> Read(ByteBuffer* buffer);
+  };
+
+  // Calls Write of the descriptor, fields that can't fail count as written.
+  template<typename Field>
+  Errorable<bool> WriteField(ByteBuffer* buffer, const typename Field::Type& value) {
+    if constexpr (std::is_void_v<decltype(Field::Write(buffer, value))>) {
+      Field::Write(buffer, value);
+      return SuccessErrorable<bool>(true);
+    } else {
+      return Field::Write(buffer, value);
+    }
+  }
+
+  template<typename Field>
+  Errorable<bool> OptionalField<Field>::Write(ByteBuffer* buffer, const Type& value) {
+    buffer->WriteBoolean(value.has_value());
+    if (value) {
+      return WriteField<Field>(buffer, *value);
+    }
+
+    return SuccessErrorable<bool>(true);
+  }
+
+  template<typename Field>
+  Errorable<typename OptionalField<Field>::Type> OptionalField<Field>::Read(ByteBuffer* buffer) {
+    ProceedErrorable(present, bool, buffer->ReadBoolean(), InvalidArgumentErrorable<Type>(IncompleteBooleanErrorable::TYPE_ORDINAL, {}, buffer->GetReadableBytes()))
+    if (!present) {
+      return SuccessErrorable<Type>(std::nullopt);
+    }
+
+    if constexpr (Field::FIXED_SIZE != 0) {
+      if (buffer->GetReadableBytes() < Field::FIXED_SIZE) {
+        return InvalidArgumentErrorable<Type>(IncompleteFieldErrorable::TYPE_ORDINAL, {}, buffer->GetReadableBytes());
+      }
+
+      return SuccessErrorable<Type>(Field::ReadUnsafe(buffer));
+    } else {
+      auto value = Field::Read(buffer);
+      if (!value.IsSuccess()) {
+        return InvalidArgumentErrorable<Type>(value.GetTypeOrdinal(), {}, value.GetErrorCode());
+      }
+
+      return SuccessErrorable<Type>(value.GetValue());
+    }
+  }
+
+  template<typename Field, uint32_t MaxLength>
+  Errorable<bool> ArrayField<Field, MaxLength>::Write(ByteBuffer* buffer, const Type& value) {
+    if (value.size() > MaxLength) {
+      return InvalidArrayLengthErrorable(value.size());
+    }
+
+    buffer->WriteVarInt(value.size());
+    for (const auto& element : value) {
+      Errorable<bool> written = WriteField<Field>(buffer, element);
+      if (!written.IsSuccess()) {
+        return written;
+      }
+    }
+
+    return SuccessErrorable<bool>(true);
+  }
+
+  template<typename Field, uint32_t MaxLength>
+  Errorable<typename ArrayField<Field, MaxLength>::Type> ArrayField<Field, MaxLength>::Read(ByteBuffer* buffer) {
+    ProceedErrorable(length, uint32_t, buffer->ReadVarInt(), InvalidArgumentErrorable<Type>(InvalidArrayLengthErrorable::TYPE_ORDINAL, {}, 0))
+    if (length > MaxLength) {
+      return InvalidArgumentErrorable<Type>(InvalidArrayLengthErrorable::TYPE_ORDINAL, {}, length);
+    }
+
+    Type elements;
+    elements.reserve(length);
+    if constexpr (Field::FIXED_SIZE != 0) {
+      // One check for all elements, the length is bounded by MaxLength so the multiplication can't overflow in practice.
+      if (buffer->GetReadableBytes() < (uint64_t) length * Field::FIXED_SIZE) {
+        return InvalidArgumentErrorable<Type>(IncompleteFieldErrorable::TYPE_ORDINAL, {}, buffer->GetReadableBytes());
+      }
+
+      for (uint32_t i = 0; i < length; ++i) {
+        elements.push_back(Field::ReadUnsafe(buffer));
+      }
+    } else {
+      for (uint32_t i = 0; i < length; ++i) {
+        auto element = Field::Read(buffer);
+        if (!element.IsSuccess()) {
+          return InvalidArgumentErrorable<Type>(element.GetTypeOrdinal(), {}, element.GetErrorCode());
+        }
+
+        elements.push_back(element.GetValue());
+      }
+    }
+
+    return SuccessErrorable<Type>(std::move(elements));
+  }
+
+  template<typename T>
+  class MemberPointerTraits;
+
+  template<typename C, typename T>
+  class MemberPointerTraits<T C::*> {
+   public:
+    using Class = C;
+    using Type = T;
+  };
+
+  // Binds a packet member to the descriptor used to (de)serialize it.
+  template<auto Member, typename Descriptor>
+  class PacketField {
+   public:
+    using Field = Descriptor;
+    using Packet = typename MemberPointerTraits<decltype(Member)>::Class;
+    static constexpr auto MEMBER = Member;
+  };
+
+  template<typename... Fields>
+  class FieldList {
+   private:
+    static constexpr uint32_t SIZES[] = {Fields::Field::FIXED_SIZE..., 0};
+
+    // Bytes of the fixed-width run starting at field I, every run is bounds checked once before decoding it.
+    template<size_t I>
+    static constexpr uint32_t RunBytes() {
+      uint32_t bytes = 0;
+      for (size_t i = I; i < sizeof...(Fields) && SIZES[i] != 0; ++i) {
+        bytes += SIZES[i];
+      }
+
+      return bytes;
+    }
+
+    template<size_t I>
+    static constexpr bool StartsRun() {
+      return SIZES[I] != 0 && (I == 0 || SIZES[I - 1] == 0);
+    }
+
+    template<size_t I, typename P>
+    static Errorable<bool> ReadField(P& packet, ByteBuffer* buffer) {
+      using Bound = std::tuple_element_t<I, std::tuple<Fields...>>;
+      if constexpr (Bound::Field::FIXED_SIZE != 0) {
+        if constexpr (StartsRun<I>()) {
+          if (buffer->GetReadableBytes() < RunBytes<I>()) {
+            return IncompleteFieldErrorable(buffer->GetReadableBytes());
+          }
+        }
+
+        packet.*Bound::MEMBER = Bound::Field::ReadUnsafe(buffer);
+      } else {
+        auto value = Bound::Field::Read(buffer);
+        if (!value.IsSuccess()) {
+          return InvalidArgumentErrorable<bool>(value.GetTypeOrdinal(), false, value.GetErrorCode());
+        }
+
+        packet.*Bound::MEMBER = value.GetValue();
+      }
+
+      return SuccessErrorable<bool>(true);
+    }
+
+    template<typename P, size_t... I>
+    static Errorable<bool> ReadFields(P& packet, ByteBuffer* buffer, std::index_sequence<I...>) {
+      Errorable<bool> result = SuccessErrorable<bool>(true);
+      ((result.IsSuccess() ? (void) (result = ReadField<I>(packet, buffer)) : (void) 0), ...);
+      return result;
+    }
+
+    template<typename P, size_t... I>
+    static uint32_t SizeOfFields(const P& packet, std::index_sequence<I...>) {
+      return (std::tuple_element_t<I, std::tuple<Fields...>>::Field::GetSize(packet.*std::tuple_element_t<I, std::tuple<Fields...>>::MEMBER) + ... + 0);
+    }
+
+   public:
+    using Bindings = std::tuple<Fields...>;
+
+    static constexpr bool ALL_FIXED = ((Fields::Field::FIXED_SIZE != 0) && ...);
+    static constexpr uint32_t FIXED_BYTES = (Fields::Field::FIXED_SIZE + ... + 0);
+
+    template<typename P>
+    static Errorable<bool> Read(P& packet, ByteBuffer* buffer) {
+      return ReadFields(packet, buffer, std::index_sequence_for<Fields...>());
+    }
+
+    // Byte offset of the I-th field within the serialized packet.
+    template<size_t I, typename P>
+    static uint32_t GetOffset(const P& packet) {
+      return SizeOfFields(packet, std::make_index_sequence<I>());
+    }
+
+    // Stops at the first field that refuses its value, the fields before it are already in the buffer.
+    template<typename P>
+    static Errorable<bool> Write(const P& packet, ByteBuffer* buffer) {
+      Errorable<bool> result = SuccessErrorable<bool>(true);
+      ((result.IsSuccess() ? (void) (result = WriteField<typename Fields::Field>(buffer, packet.*Fields::MEMBER)) : (void) 0), ...);
+      return result;
+    }
+
+    template<typename P>
+    static uint32_t GetSize(const P& packet) {
+      if constexpr (ALL_FIXED) {
+        return FIXED_BYTES;
+      } else {
+        return (Fields::Field::GetSize(packet.*Fields::MEMBER) + ... + 0);
+      }
+    }
+  };
+
+  // Derives Write, Size and Instantiate from Self::PacketFields, a FieldList declared inside Self after its members.
+  template<typename Self>
+  class FieldPacket : public Packet {
+   public:
+    Errorable<bool> Write(const ProtocolVersion* version, ByteBuffer* buffer) const override {
+      return Self::PacketFields::Write(static_cast<const Self&>(*this), buffer);
+    }
+
+    uint32_t Size(const ProtocolVersion* version) const override {
+      return Self::PacketFields::GetSize(static_cast<const Self&>(*this));
+    }
+
+    static Errorable<Self> Instantiate(const PacketHolder& holder) {
+      Self packet;
+      if (!Self::PacketFields::Read(packet, holder.GetCurrentBuffer()).IsSuccess()) {
+        return InvalidPacketErrorable<Self>(holder.GetOrdinal());
+      }
+
+      return SuccessErrorable<Self>(packet);
+    }
+  };
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../../utils/ordinal/OrdinalRegistry.hpp"
+#include "../registry/VersionRegistry.hpp"
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+namespace Ship {
+  // Compile-time list of the packets of one protocol state and direction, compile-time tables are indexed by the position in the list.
+  // Positions therefore do not depend on static initialization or link order, unlike the ones from OrdinalRegistry. At runtime
+  // the list owns a block of OrdinalRegistry::PacketRegistry ordinals, so its packets never collide with dynamically registered ones.
+  template<typename... Packets>
+  class PacketList {
+   private:
+    template<typename P>
+    static constexpr uint32_t FindOrdinal() {
+      constexpr bool matches[] = {std::is_same_v<P, Packets>..., false};
+      for (uint32_t ordinal = 0; ordinal < sizeof...(Packets); ++ordinal) {
+        if (matches[ordinal]) {
+          return ordinal;
+        }
+      }
+
+      return NONE;
+    }
+
+   public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr uint32_t SIZE = sizeof...(Packets);
+
+    template<typename P>
+    static constexpr bool Contains() {
+      return FindOrdinal<P>() != NONE;
+    }
+
+    template<typename P>
+    static constexpr uint32_t OrdinalOf() {
+      static_assert(FindOrdinal<P>() != NONE, "Packet is not part of this PacketList");
+      return FindOrdinal<P>();
+    }
+
+    template<uint32_t Ordinal>
+    using At = std::tuple_element_t<Ordinal, std::tuple<Packets...>>;
+
+    // First ordinal of the block, reserved on first use.
+    static uint32_t GetBaseOrdinal() {
+      static const uint32_t baseOrdinal = OrdinalRegistry::PacketRegistry.RegisterOrdinals(SIZE);
+      return baseOrdinal;
+    }
+
+    // Ordinal seen by handlers and registries, packets of the list return it from Packet::GetOrdinal.
+    template<typename P>
+    static uint32_t GetOrdinal() {
+      return GetBaseOrdinal() + OrdinalOf<P>();
+    }
+  };
+
+  // Packet ids of one protocol version, given as the packets of List in the order of their ids.
+  template<typename List, typename... PacketsInIDOrder>
+  class PacketVersionMapping {
+   private:
+    static constexpr std::array<uint32_t, List::SIZE> BuildOrdinalToID() {
+      std::array<uint32_t, List::SIZE> ordinalToID {};
+      for (uint32_t& id : ordinalToID) {
+        id = List::NONE;
+      }
+
+      constexpr uint32_t ordinals[] = {List::template OrdinalOf<PacketsInIDOrder>()..., List::NONE};
+      for (uint32_t id = 0; id < sizeof...(PacketsInIDOrder); ++id) {
+        ordinalToID[ordinals[id]] = id;
+      }
+
+      return ordinalToID;
+    }
+
+   public:
+    static constexpr std::array<uint32_t, sizeof...(PacketsInIDOrder)> ID_TO_ORDINAL = {List::template OrdinalOf<PacketsInIDOrder>()...};
+    static constexpr std::array<uint32_t, List::SIZE> ORDINAL_TO_ID = BuildOrdinalToID();
+
+    static constexpr uint32_t GetOrdinalByID(uint32_t id) {
+      return id < ID_TO_ORDINAL.size() ? ID_TO_ORDINAL[id] : List::NONE;
+    }
+
+    static constexpr uint32_t GetIDByOrdinal(uint32_t ordinal) {
+      return ordinal < ORDINAL_TO_ID.size() ? ORDINAL_TO_ID[ordinal] : List::NONE;
+    }
+
+    // Bridge to the runtime registries, e.g. VersionedRegistry::RegisterVersion, which keep serving dynamically loaded packets.
+    // The registry maps ids to the runtime ordinals of the list, see PacketList::GetOrdinal.
+    static VersionRegistry* NewVersionRegistry() {
+      std::vector<uint32_t> ordinals(ID_TO_ORDINAL.begin(), ID_TO_ORDINAL.end());
+      for (uint32_t& ordinal : ordinals) {
+        ordinal += List::GetBaseOrdinal();
+      }
+
+      return new VersionRegistry(ordinals);
+    }
+  };
+}
@@ -0,0 +1,146 @@
+#include "PacketTemplate.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace Ship {
+  PacketTemplate::PacketTemplate(uint8_t* bytes, uint32_t size, uint32_t ordinal, const ProtocolVersion* version, std::vector<TemplateField> fields)
+    : bytes(bytes), size(size), ordinal(ordinal), version(version), fields(std::move(fields)) {
+  }
+
+  PacketTemplate::~PacketTemplate() {
+    delete[] bytes;
+  }
+
+  Errorable<PacketTemplate*> PacketTemplate::NewPacketTemplate(const Packet& packet, const ProtocolVersion* version, std::vector<TemplateField> fields) {
+    if (fields.size() > MAX_FIELDS) {
+      return InvalidPacketTemplateErrorable(MAX_FIELDS);
+    }
+
+    ByteBufferImpl buffer(std::max(packet.Size(version), 1U));
+    if (!packet.Write(version, &buffer).IsSuccess()) {
+      return InvalidPacketTemplateErrorable(fields.size());
+    }
+
+    uint32_t size = buffer.GetReadableBytes();
+    uint32_t minimumOffset = 0;
+    for (uint32_t i = 0; i < fields.size(); ++i) {
+      TemplateField& field = fields[i];
+      if (field.offset < minimumOffset || field.offset >= size) {
+        return InvalidPacketTemplateErrorable(i);
+      }
+
+      field.value = 0;
+      if (field.type == TemplateFieldType::VAR_INT) {
+        Errorable<uint32_t> value = buffer.PeekVarInt(field.offset);
+        if (!value.IsSuccess()) {
+          return InvalidPacketTemplateErrorable(i);
+        }
+
+        field.value = value.GetValue();
+        field.width = 1;
+        while (buffer.PeekByteUnsafe(field.offset + field.width - 1) & 0x80) {
+          ++field.width;
+        }
+      } else {
+        field.width = 1U << (uint32_t) field.type;
+        if (field.offset + field.width > size) {
+          return InvalidPacketTemplateErrorable(i);
+        }
+
+        for (uint32_t j = 0; j < field.width; ++j) {
+          field.value = field.value << 8 | buffer.PeekByteUnsafe(field.offset + j);
+        }
+      }
+
+      minimumOffset = field.offset + field.width;
+    }
+
+    auto* bytes = new uint8_t[size];
+    buffer.ReadBytes(bytes, size);
+    return SuccessErrorable<PacketTemplate*>(new PacketTemplate(bytes, size, packet.GetOrdinal(), version, std::move(fields)));
+  }
+
+  void PacketTemplate::Write(ByteBuffer* buffer, const uint64_t* values) const {
+    uint32_t position = 0;
+    for (uint32_t i = 0; i < fields.size(); ++i) {
+      const TemplateField& field = fields[i];
+      buffer->WriteBytes(bytes + position, field.offset - position);
+      switch (field.type) {
+        case TemplateFieldType::BYTE:
+          buffer->WriteByte(values[i]);
+          break;
+        case TemplateFieldType::SHORT:
+          buffer->WriteShort(values[i]);
+          break;
+        case TemplateFieldType::INT:
+          buffer->WriteInt(values[i]);
+          break;
+        case TemplateFieldType::LONG:
+          buffer->WriteLong(values[i]);
+          break;
+        case TemplateFieldType::VAR_INT:
+          // Re-encoded on its own, so a value that needs another width than the template one is still written correctly.
+          buffer->WriteVarInt(values[i]);
+          break;
+      }
+
+      position = field.offset + field.width;
+    }
+
+    buffer->WriteBytes(bytes + position, size - position);
+  }
+
+  uint32_t PacketTemplate::Size(const uint64_t* values) const {
+    uint32_t patchedSize = size;
+    for (uint32_t i = 0; i < fields.size(); ++i) {
+      if (fields[i].type == TemplateFieldType::VAR_INT) {
+        patchedSize += ByteBuffer::VarIntBytes(values[i]) - fields[i].width;
+      }
+    }
+
+    return patchedSize;
+  }
+
+  uint32_t PacketTemplate::GetOrdinal() const {
+    return ordinal;
+  }
+
+  const ProtocolVersion* PacketTemplate::GetVersion() const {
+    return version;
+  }
+
+  uint32_t PacketTemplate::GetFieldCount() const {
+    return fields.size();
+  }
+
+  uint64_t PacketTemplate::GetFieldValue(uint32_t index) const {
+    return fields[index].value;
+  }
+
+  PatchedPacket::PatchedPacket(const PacketTemplate* packet_template) : packetTemplate(packet_template), values() {
+    for (uint32_t i = 0; i < packetTemplate->GetFieldCount(); ++i) {
+      values[i] = packetTemplate->GetFieldValue(i);
+    }
+  }
+
+  void PatchedPacket::SetField(uint32_t index, uint64_t value) {
+    values[index] = value;
+  }
+
+  Errorable<bool> PatchedPacket::Write(const ProtocolVersion* version, ByteBuffer* buffer) const {
+    if (version != packetTemplate->GetVersion()) {
+      return InvalidSerializableWriteErrorable(packetTemplate->GetOrdinal());
+    }
+
+    packetTemplate->Write(buffer, values);
+    return SuccessErrorable<bool>(true);
+  }
+
+  uint32_t PatchedPacket::Size(const ProtocolVersion* version) const {
+    return packetTemplate->Size(values);
+  }
+
+  uint32_t PatchedPacket::GetOrdinal() const {
+    return packetTemplate->GetOrdinal();
+  }
+}
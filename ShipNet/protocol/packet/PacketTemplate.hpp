@@ -0,0 +1,102 @@
+#pragma once
+
+#include "FieldPacket.hpp"
+#include <vector>
+
+namespace Ship {
+  enum class TemplateFieldType {
+    BYTE,
+    SHORT,
+    INT,
+    LONG,
+    VAR_INT
+  };
+
+  class TemplateField {
+   public:
+    uint32_t offset;
+    TemplateFieldType type;
+    // Width of the encoded value in the template, filled in by PacketTemplate.
+    uint32_t width = 0;
+    uint64_t value = 0;
+  };
+
+  class PacketTemplate;
+
+  CreateInvalidArgumentErrorable(InvalidPacketTemplateErrorable, PacketTemplate*, "Template field doesn't fit the serialized packet, field index");
+
+  // A packet serialized once for a single protocol version, the designated fields are patched on every send instead of
+  // serializing the whole packet again.
+  class PacketTemplate {
+   private:
+    uint8_t* bytes;
+    uint32_t size;
+    uint32_t ordinal;
+    const ProtocolVersion* version;
+    std::vector<TemplateField> fields;
+
+    PacketTemplate(uint8_t* bytes, uint32_t size, uint32_t ordinal, const ProtocolVersion* version, std::vector<TemplateField> fields);
+
+   public:
+    static constexpr uint32_t MAX_FIELDS = 8;
+
+    ~PacketTemplate();
+
+    PacketTemplate(const PacketTemplate&) = delete;
+    PacketTemplate& operator=(const PacketTemplate&) = delete;
+
+    // Fields have to be sorted by offset and must not overlap, at most MAX_FIELDS of them.
+    static Errorable<PacketTemplate*> NewPacketTemplate(const Packet& packet, const ProtocolVersion* version, std::vector<TemplateField> fields);
+
+    // Offset of the I-th field of a FieldPacket, its descriptor has to be fixed-width or VarIntField.
+    template<size_t I, typename P>
+    static TemplateField FieldOf(const P& packet) {
+      using Field = typename std::tuple_element_t<I, typename P::PacketFields::Bindings>::Field;
+      static_assert(Field::FIXED_SIZE == 1 || Field::FIXED_SIZE == 2 || Field::FIXED_SIZE == 4 || Field::FIXED_SIZE == 8
+                      || std::is_same_v<Field, VarIntField>,
+        "Only fixed-width and VarInt fields can be patched");
+
+      TemplateFieldType type = TemplateFieldType::VAR_INT;
+      switch (Field::FIXED_SIZE) {
+        case 1:
+          type = TemplateFieldType::BYTE;
+          break;
+        case 2:
+          type = TemplateFieldType::SHORT;
+          break;
+        case 4:
+          type = TemplateFieldType::INT;
+          break;
+        case 8:
+          type = TemplateFieldType::LONG;
+          break;
+      }
+
+      return {P::PacketFields::template GetOffset<I>(packet), type};
+    }
+
+    void Write(ByteBuffer* buffer, const uint64_t* values) const;
+    [[nodiscard]] uint32_t Size(const uint64_t* values) const;
+
+    [[nodiscard]] uint32_t GetOrdinal() const;
+    [[nodiscard]] const ProtocolVersion* GetVersion() const;
+    [[nodiscard]] uint32_t GetFieldCount() const;
+    [[nodiscard]] uint64_t GetFieldValue(uint32_t index) const;
+  };
+
+  // Lightweight packet sent through the usual pipeline, holds only the patched values. The template must outlive it.
+  class PatchedPacket : public Packet {
+   private:
+    const PacketTemplate* packetTemplate;
+    uint64_t values[PacketTemplate::MAX_FIELDS];
+
+   public:
+    explicit PatchedPacket(const PacketTemplate* packet_template);
+
+    void SetField(uint32_t index, uint64_t value);
+
+    Errorable<bool> Write(const ProtocolVersion* version, ByteBuffer* buffer) const override;
+    [[nodiscard]] uint32_t Size(const ProtocolVersion* version) const override;
+    [[nodiscard]] uint32_t GetOrdinal() const override;
+  };
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "FrozenVersionedRegistry.hpp"
+#include "RegistryImage.hpp"
 #include "VersionRegistry.hpp"
 #include "VersionedRegistry.hpp"
 #include <functional>
@@ -89,5 +91,70 @@ namespace Ship {
     [[nodiscard]] size_t GetConstructorCount() const {
       return ordinalToObjectMap.size();
     }
+
+    [[nodiscard]] const std::function<Errorable<T*>(const ProtocolVersion* version, ByteBuffer* buffer)>* GetConstructor(uint32_t ordinal) const {
+      return ordinal < ordinalToObjectMap.size() && ordinalToObjectMap[ordinal] ? &ordinalToObjectMap[ordinal] : nullptr;
+    }
+  };
+
+  template<typename T>
+  class FrozenConstructorRegistry : public FrozenVersionedRegistry {
+   public:
+    struct Entry {
+      uint32_t ordinal;
+      const std::function<Errorable<T*>(const ProtocolVersion* version, ByteBuffer* buffer)>* constructor;
+    };
+
+   private:
+    std::vector<std::function<Errorable<T*>(const ProtocolVersion* version, ByteBuffer* buffer)>> constructors;
+    std::vector<Entry> entries;
+
+    void BuildEntries(const ConstructorRegistry<T>& registry) {
+      constructors.resize(registry.GetConstructorCount());
+      for (uint32_t ordinal = 0; ordinal < constructors.size(); ++ordinal) {
+        auto constructor = registry.GetConstructor(ordinal);
+        if (constructor) {
+          constructors[ordinal] = *constructor;
+        }
+      }
+
+      entries.resize(GetIDTableSize());
+      for (size_t i = 0; i < entries.size(); ++i) {
+        uint32_t ordinal = idToOrdinalTable[i];
+        entries[i] = {ordinal, ordinal < constructors.size() && constructors[ordinal] ? &constructors[ordinal] : nullptr};
+      }
+    }
+
+   public:
+    // Copies the constructors, so the source registry may be changed or destroyed afterwards.
+    explicit FrozenConstructorRegistry(const ConstructorRegistry<T>& registry) : FrozenVersionedRegistry(registry) {
+      BuildEntries(registry);
+    }
+
+    // Takes the id tables from an image mapped against this registry, see RegistryImage::Map, only the constructors are copied from it.
+    FrozenConstructorRegistry(const RegistryImage& image, const ConstructorRegistry<T>& registry) : FrozenVersionedRegistry(image) {
+      BuildEntries(registry);
+    }
+
+    FrozenConstructorRegistry(const FrozenConstructorRegistry&) = delete;
+    FrozenConstructorRegistry& operator=(const FrozenConstructorRegistry&) = delete;
+
+    // Unregistered ids resolve to an entry with ordinal NONE, ids without a constructor to a null constructor.
+    [[nodiscard]] Entry Find(const ProtocolVersion* version, uint32_t id) const {
+      return id < idStride ? entries[RowOf(version) * idStride + id] : Entry {NONE, nullptr};
+    }
+
+    Errorable<T*> GetObjectByID(const ProtocolVersion* version, uint32_t id, ByteBuffer* buffer) const {
+      Entry entry = Find(version, id);
+      if (entry.ordinal == NONE) {
+        return NoConstructorOrdinalExistErrorable<T*>(id);
+      }
+
+      if (!entry.constructor) {
+        return NoConstructorExistErrorable<T*>(entry.ordinal);
+      }
+
+      return (*entry.constructor)(version, buffer);
+    }
   };
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "FrozenVersionedRegistry.hpp"
+#include "RegistryImage.hpp"
+
+namespace Ship {
+  const uint32_t FrozenVersionedRegistry::NONE = UINT32_MAX;
+
+  FrozenVersionedRegistry::FrozenVersionedRegistry(const VersionedRegistry& registry)
+    : maximumVersionOrdinal(registry.GetVersions().GetMaximumVersion().GetOrdinal()) {
+    for (uint32_t versionOrdinal = 0; versionOrdinal <= maximumVersionOrdinal; ++versionOrdinal) {
+      const VersionRegistry* versionRegistry = registry.GetVersionRegistry(registry.GetVersions().FromOrdinal(versionOrdinal));
+      if (versionRegistry) {
+        idStride = std::max(idStride, (uint32_t) versionRegistry->GetIDCount());
+        ordinalStride = std::max(ordinalStride, (uint32_t) versionRegistry->GetOrdinalCount());
+      }
+    }
+
+    ownedIDToOrdinalTable.assign((size_t) (maximumVersionOrdinal + 1) * idStride, NONE);
+    ownedOrdinalToIDTable.assign((size_t) (maximumVersionOrdinal + 1) * ordinalStride, NONE);
+    for (uint32_t versionOrdinal = 0; versionOrdinal <= maximumVersionOrdinal; ++versionOrdinal) {
+      const VersionRegistry* versionRegistry = registry.GetVersionRegistry(registry.GetVersions().FromOrdinal(versionOrdinal));
+      if (!versionRegistry) {
+        continue;
+      }
+
+      for (uint32_t id = 0; id < versionRegistry->GetIDCount(); ++id) {
+        if (versionRegistry->IsRegisteredID(id)) {
+          uint32_t ordinal = versionRegistry->GetOrdinalByID(id).GetValue();
+          ownedIDToOrdinalTable[versionOrdinal * idStride + id] = ordinal;
+          ownedOrdinalToIDTable[versionOrdinal * ordinalStride + ordinal] = id;
+        }
+      }
+    }
+
+    idToOrdinalTable = ownedIDToOrdinalTable.data();
+    ordinalToIDTable = ownedOrdinalToIDTable.data();
+  }
+
+  FrozenVersionedRegistry::FrozenVersionedRegistry(const RegistryImage& image)
+    : maximumVersionOrdinal(image.GetHeader().maximumVersionOrdinal), idStride(image.GetHeader().idStride),
+      ordinalStride(image.GetHeader().ordinalStride), idToOrdinalTable(image.GetIDToOrdinalTable()), ordinalToIDTable(image.GetOrdinalToIDTable()) {
+  }
+
+  uint32_t FrozenVersionedRegistry::GetMaximumVersionOrdinal() const {
+    return maximumVersionOrdinal;
+  }
+
+  uint32_t FrozenVersionedRegistry::GetIDStride() const {
+    return idStride;
+  }
+
+  uint32_t FrozenVersionedRegistry::GetOrdinalStride() const {
+    return ordinalStride;
+  }
+
+  const uint32_t* FrozenVersionedRegistry::GetIDToOrdinalTable() const {
+    return idToOrdinalTable;
+  }
+
+  const uint32_t* FrozenVersionedRegistry::GetOrdinalToIDTable() const {
+    return ordinalToIDTable;
+  }
+
+  size_t FrozenVersionedRegistry::GetIDTableSize() const {
+    return (size_t) (maximumVersionOrdinal + 1) * idStride;
+  }
+
+  size_t FrozenVersionedRegistry::GetOrdinalTableSize() const {
+    return (size_t) (maximumVersionOrdinal + 1) * ordinalStride;
+  }
+
+  size_t FrozenVersionedRegistry::GetTableBytes() const {
+    return (GetIDTableSize() + GetOrdinalTableSize()) * sizeof(uint32_t);
+  }
+}
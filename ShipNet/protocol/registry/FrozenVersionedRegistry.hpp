@@ -0,0 +1,53 @@
+#pragma once
+
+#include "VersionedRegistry.hpp"
+#include <algorithm>
+
+namespace Ship {
+  class RegistryImage;
+
+  class FrozenVersionedRegistry {
+   private:
+    std::vector<uint32_t> ownedIDToOrdinalTable;
+    std::vector<uint32_t> ownedOrdinalToIDTable;
+
+   protected:
+    uint32_t maximumVersionOrdinal;
+    uint32_t idStride = 0;
+    uint32_t ordinalStride = 0;
+    const uint32_t* idToOrdinalTable;
+    const uint32_t* ordinalToIDTable;
+
+    [[nodiscard]] uint32_t RowOf(const ProtocolVersion* version) const {
+      // UNKNOWN has the largest possible ordinal, so it falls back to the maximum version like VersionedRegistry does.
+      return std::min(version->GetOrdinal(), maximumVersionOrdinal);
+    }
+
+   public:
+    static const uint32_t NONE;
+
+    explicit FrozenVersionedRegistry(const VersionedRegistry& registry);
+    // Uses the mapped tables in place, the image has to outlive this registry.
+    explicit FrozenVersionedRegistry(const RegistryImage& image);
+
+    FrozenVersionedRegistry(const FrozenVersionedRegistry&) = delete;
+    FrozenVersionedRegistry& operator=(const FrozenVersionedRegistry&) = delete;
+
+    [[nodiscard]] uint32_t GetOrdinalByID(const ProtocolVersion* version, uint32_t id) const {
+      return id < idStride ? idToOrdinalTable[RowOf(version) * idStride + id] : NONE;
+    }
+
+    [[nodiscard]] uint32_t GetIDByOrdinal(const ProtocolVersion* version, uint32_t ordinal) const {
+      return ordinal < ordinalStride ? ordinalToIDTable[RowOf(version) * ordinalStride + ordinal] : NONE;
+    }
+
+    [[nodiscard]] uint32_t GetMaximumVersionOrdinal() const;
+    [[nodiscard]] uint32_t GetIDStride() const;
+    [[nodiscard]] uint32_t GetOrdinalStride() const;
+    [[nodiscard]] const uint32_t* GetIDToOrdinalTable() const;
+    [[nodiscard]] const uint32_t* GetOrdinalToIDTable() const;
+    [[nodiscard]] size_t GetIDTableSize() const;
+    [[nodiscard]] size_t GetOrdinalTableSize() const;
+    [[nodiscard]] size_t GetTableBytes() const;
+  };
+}
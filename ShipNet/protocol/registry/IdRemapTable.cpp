@@ -0,0 +1,59 @@
+#include "IdRemapTable.hpp"
+
+namespace Ship {
+  const uint32_t IdRemapTable::UNMAPPED = UINT32_MAX;
+
+  IdRemapTable::IdRemapTable(const VersionRegistry* source, const VersionRegistry* target) {
+    sourceToTargetMap.resize(source->GetIDCount(), UNMAPPED);
+
+    for (uint32_t id = 0; id < sourceToTargetMap.size(); ++id) {
+      if (!source->IsRegisteredID(id)) {
+        continue;
+      }
+
+      uint32_t ordinal = source->GetOrdinalByID(id).GetValue();
+      Errorable<uint32_t> targetID = target->GetIDByOrdinal(ordinal);
+      if (targetID.IsSuccess() && target->IsRegisteredID(targetID.GetValue()) && target->GetOrdinalByID(targetID.GetValue()).GetValue() == ordinal) {
+        sourceToTargetMap[id] = targetID.GetValue();
+      }
+
+      identity &= sourceToTargetMap[id] == id;
+    }
+  }
+
+  bool IdRemapTable::IsIdentity() const {
+    return identity;
+  }
+
+  size_t IdRemapTable::GetSize() const {
+    return sourceToTargetMap.size();
+  }
+
+  Errorable<uint32_t> IdRemapTable::RewriteFrame(ByteBuffer* in, uint32_t frame_size, ByteBuffer* out) const {
+    Errorable<uint32_t> idErrorable = in->PeekVarInt(0);
+    if (!idErrorable.IsSuccess()) {
+      return idErrorable;
+    }
+
+    uint32_t id = idErrorable.GetValue();
+    uint32_t idBytes = 1;
+    while (in->PeekByteUnsafe(idBytes - 1) & 0x80) {
+      ++idBytes;
+    }
+
+    if (idBytes > frame_size) {
+      return InvalidVarIntErrorable(id);
+    }
+
+    uint32_t targetID = Remap(id);
+    if (targetID == UNMAPPED) {
+      return UnmappedPacketIdErrorable(id);
+    }
+
+    in->SkipReadBytes(idBytes);
+    out->WriteVarInt(frame_size - idBytes + ByteBuffer::VarIntBytes(targetID));
+    out->WriteVarInt(targetID);
+    out->WriteBytes(in, frame_size - idBytes);
+    return SuccessErrorable<uint32_t>(targetID);
+  }
+}
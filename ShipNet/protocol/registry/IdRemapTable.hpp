@@ -0,0 +1,28 @@
+#pragma once
+
+#include "VersionRegistry.hpp"
+
+namespace Ship {
+  CreateInvalidArgumentErrorable(UnmappedPacketIdErrorable, uint32_t, "Packet id has no counterpart in the target version");
+
+  class IdRemapTable {
+   private:
+    std::vector<uint32_t> sourceToTargetMap;
+    bool identity = true;
+
+   public:
+    static const uint32_t UNMAPPED;
+
+    IdRemapTable(const VersionRegistry* source, const VersionRegistry* target);
+
+    [[nodiscard]] uint32_t Remap(uint32_t id) const {
+      return id < sourceToTargetMap.size() ? sourceToTargetMap[id] : UNMAPPED;
+    }
+
+    [[nodiscard]] bool IsIdentity() const;
+    [[nodiscard]] size_t GetSize() const;
+
+    // Writes the frame length-prefixed into out with only the leading packet id replaced, the body is moved over untouched.
+    Errorable<uint32_t> RewriteFrame(ByteBuffer* in, uint32_t frame_size, ByteBuffer* out) const;
+  };
+}
@@ -0,0 +1,184 @@
+#include "RegistryImage.hpp"
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Ship {
+  const uint32_t RegistryImage::MAGIC = 0x49524853;
+  const uint32_t RegistryImage::FORMAT_VERSION = 2;
+  const uint64_t RegistryImage::WRONG_MAGIC = 1;
+  const uint64_t RegistryImage::WRONG_FORMAT_VERSION = 2;
+  const uint64_t RegistryImage::WRONG_FINGERPRINT = 3;
+  const uint64_t RegistryImage::WRONG_SIZE = 4;
+  const uint64_t RegistryImage::WRONG_CHECKSUM = 5;
+
+  static uint64_t ChecksumWords(uint64_t hash, const uint32_t* words, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      hash = (hash ^ words[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+  }
+
+  static uint64_t StructureChecksum(const RegistryImageHeader& header) {
+    const uint32_t fields[] = {header.magic, header.formatVersion, (uint32_t) header.fingerprint, (uint32_t) (header.fingerprint >> 32),
+      header.maximumVersionOrdinal, header.idStride, header.ordinalStride};
+    return ChecksumWords(14695981039346656037ULL, fields, sizeof(fields) / sizeof(uint32_t));
+  }
+
+  static size_t TableWords(const RegistryImageHeader& header) {
+    return (size_t) (header.maximumVersionOrdinal + 1) * (header.idStride + header.ordinalStride);
+  }
+
+  RegistryImage::RegistryImage(void* mapping, size_t mapping_size) : mapping(mapping), mappingSize(mapping_size) {
+  }
+
+  RegistryImage::~RegistryImage() {
+    munmap(mapping, mappingSize);
+  }
+
+  uint64_t RegistryImage::Fingerprint(const VersionedRegistry& registry) {
+    const ProtocolVersions& versions = registry.GetVersions();
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint32_t ordinal = 0; ordinal <= versions.GetMaximumVersion().GetOrdinal(); ++ordinal) {
+      const ProtocolVersion* version = versions.FromOrdinal(ordinal);
+      const VersionRegistry* versionRegistry = registry.GetVersionRegistry(version);
+      const uint32_t fields[] = {version->GetOrdinal(), version->GetProtocolID(), versionRegistry ? (uint32_t) versionRegistry->GetIDCount() : 0,
+        versionRegistry ? (uint32_t) versionRegistry->GetOrdinalCount() : 0};
+      hash = ChecksumWords(hash, fields, sizeof(fields) / sizeof(uint32_t));
+      if (!versionRegistry) {
+        continue;
+      }
+
+      for (uint32_t id = 0; id < versionRegistry->GetIDCount(); ++id) {
+        if (versionRegistry->IsRegisteredID(id)) {
+          const uint32_t pair[] = {id, versionRegistry->GetOrdinalByID(id).GetValue()};
+          hash = ChecksumWords(hash, pair, 2);
+        }
+      }
+    }
+
+    return hash;
+  }
+
+  Errorable<bool> RegistryImage::Write(const std::string& path, const VersionedRegistry& source) {
+    FrozenVersionedRegistry registry(source);
+    RegistryImageHeader header {MAGIC, FORMAT_VERSION, Fingerprint(source), registry.GetMaximumVersionOrdinal(), registry.GetIDStride(),
+      registry.GetOrdinalStride(), 0, 0, 0};
+    header.structureChecksum = StructureChecksum(header);
+    header.payloadChecksum = ChecksumWords(ChecksumWords(14695981039346656037ULL, registry.GetIDToOrdinalTable(), registry.GetIDTableSize()),
+      registry.GetOrdinalToIDTable(), registry.GetOrdinalTableSize());
+
+    // Written next to the target and renamed over it, so concurrently starting instances never map a partial image.
+    std::string temporaryPath = path + ".tmp." + std::to_string(getpid());
+    int fileDescriptor = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fileDescriptor == -1) {
+      return ErrnoErrorable<bool>(false);
+    }
+
+    const std::pair<const void*, size_t> parts[] = {
+      {&header, sizeof(header)},
+      {registry.GetIDToOrdinalTable(), registry.GetIDTableSize() * sizeof(uint32_t)},
+      {registry.GetOrdinalToIDTable(), registry.GetOrdinalTableSize() * sizeof(uint32_t)},
+    };
+
+    for (const auto& part : parts) {
+      const auto* data = (const uint8_t*) part.first;
+      size_t remaining = part.second;
+      while (remaining != 0) {
+        ssize_t written = write(fileDescriptor, data, remaining);
+        if (written == -1) {
+          if (errno == EINTR) {
+            continue;
+          }
+
+          ErrnoErrorable<bool> errorable(false);
+          close(fileDescriptor);
+          unlink(temporaryPath.c_str());
+          return errorable;
+        }
+
+        data += written;
+        remaining -= written;
+      }
+    }
+
+    if (fsync(fileDescriptor) == -1 || close(fileDescriptor) == -1 || rename(temporaryPath.c_str(), path.c_str()) == -1) {
+      ErrnoErrorable<bool> errorable(false);
+      unlink(temporaryPath.c_str());
+      return errorable;
+    }
+
+    return SuccessErrorable<bool>(true);
+  }
+
+  Errorable<RegistryImage*> RegistryImage::Map(const std::string& path, const VersionedRegistry& registry) {
+    int fileDescriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor == -1) {
+      return ErrnoErrorable<RegistryImage*>(nullptr);
+    }
+
+    struct stat fileStat {};
+    if (fstat(fileDescriptor, &fileStat) == -1) {
+      ErrnoErrorable<RegistryImage*> errorable(nullptr);
+      close(fileDescriptor);
+      return errorable;
+    }
+
+    if ((size_t) fileStat.st_size < sizeof(RegistryImageHeader)) {
+      close(fileDescriptor);
+      return InvalidRegistryImageErrorable(WRONG_SIZE);
+    }
+
+    int mappingFlags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    mappingFlags |= MAP_POPULATE;
+#endif
+
+    size_t mappingSize = fileStat.st_size;
+    void* mapping = mmap(nullptr, mappingSize, PROT_READ, mappingFlags, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (mapping == MAP_FAILED) {
+      return ErrnoErrorable<RegistryImage*>(nullptr);
+    }
+
+    auto* image = new RegistryImage(mapping, mappingSize);
+    const RegistryImageHeader& header = image->GetHeader();
+    uint64_t reason = 0;
+    if (header.magic != MAGIC) {
+      reason = WRONG_MAGIC;
+    } else if (header.formatVersion != FORMAT_VERSION) {
+      reason = WRONG_FORMAT_VERSION;
+    } else if (header.structureChecksum != StructureChecksum(header)) {
+      reason = WRONG_CHECKSUM;
+    } else if (header.fingerprint != Fingerprint(registry)) {
+      reason = WRONG_FINGERPRINT;
+    } else if (mappingSize != sizeof(RegistryImageHeader) + TableWords(header) * sizeof(uint32_t)) {
+      reason = WRONG_SIZE;
+    } else if (header.payloadChecksum != ChecksumWords(14695981039346656037ULL, image->GetIDToOrdinalTable(), TableWords(header))) {
+      reason = WRONG_CHECKSUM;
+    }
+
+    if (reason != 0) {
+      delete image;
+      return InvalidRegistryImageErrorable(reason);
+    }
+
+    return SuccessErrorable<RegistryImage*>(image);
+  }
+
+  const RegistryImageHeader& RegistryImage::GetHeader() const {
+    return *(const RegistryImageHeader*) mapping;
+  }
+
+  const uint32_t* RegistryImage::GetIDToOrdinalTable() const {
+    return (const uint32_t*) ((const uint8_t*) mapping + sizeof(RegistryImageHeader));
+  }
+
+  const uint32_t* RegistryImage::GetOrdinalToIDTable() const {
+    const RegistryImageHeader& header = GetHeader();
+    return GetIDToOrdinalTable() + (size_t) (header.maximumVersionOrdinal + 1) * header.idStride;
+  }
+}
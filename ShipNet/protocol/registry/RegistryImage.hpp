@@ -0,0 +1,54 @@
+#pragma once
+
+#include "FrozenVersionedRegistry.hpp"
+#include <string>
+
+namespace Ship {
+  CreateInvalidArgumentErrorable(InvalidRegistryImageErrorable, RegistryImage*, "Registry image is corrupted or does not match, reason");
+
+  struct RegistryImageHeader {
+    uint32_t magic;
+    uint32_t formatVersion;
+    uint64_t fingerprint;
+    uint32_t maximumVersionOrdinal;
+    uint32_t idStride;
+    uint32_t ordinalStride;
+    uint32_t reserved;
+    uint64_t structureChecksum;
+    uint64_t payloadChecksum;
+  };
+
+  // Read-only mapping of a frozen registry written by Write, the tables are used in place without copying.
+  class RegistryImage {
+   private:
+    void* mapping;
+    size_t mappingSize;
+
+    RegistryImage(void* mapping, size_t mapping_size);
+
+   public:
+    static const uint32_t MAGIC;
+    static const uint32_t FORMAT_VERSION;
+    static const uint64_t WRONG_MAGIC;
+    static const uint64_t WRONG_FORMAT_VERSION;
+    static const uint64_t WRONG_FINGERPRINT;
+    static const uint64_t WRONG_SIZE;
+    static const uint64_t WRONG_CHECKSUM;
+
+    ~RegistryImage();
+
+    RegistryImage(const RegistryImage&) = delete;
+    RegistryImage& operator=(const RegistryImage&) = delete;
+
+    // Digest of the versions and of every registered id/ordinal pair of the registry, so an image only maps against the
+    // registrations it was built from.
+    static uint64_t Fingerprint(const VersionedRegistry& registry);
+    static Errorable<bool> Write(const std::string& path, const VersionedRegistry& source);
+    // Rejects images whose fingerprint differs from the one of the live registry with WRONG_FINGERPRINT.
+    static Errorable<RegistryImage*> Map(const std::string& path, const VersionedRegistry& registry);
+
+    [[nodiscard]] const RegistryImageHeader& GetHeader() const;
+    [[nodiscard]] const uint32_t* GetIDToOrdinalTable() const;
+    [[nodiscard]] const uint32_t* GetOrdinalToIDTable() const;
+  };
+}
@@ -1,7 +1,14 @@
 #include "VersionRegistry.hpp"
 #include "../../utils/ordinal/OrdinalVector.hpp"
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
 
 namespace Ship {
+  const uint32_t VersionRegistry::UNREGISTERED = UINT32_MAX;
+
+  static std::mutex internMutex;
+  static std::unordered_multimap<size_t, std::weak_ptr<const VersionRegistry>> internedRegistries;
 
   VersionRegistry::VersionRegistry(const std::vector<uint32_t>& ordinals) {
     idToOrdinalMap = ordinals;
@@ -12,7 +19,68 @@ namespace Ship {
     }
   }
 
+  VersionRegistry::VersionRegistry(std::shared_ptr<const VersionRegistry> base_registry, const VersionRegistry& full)
+    : base(std::move(base_registry)), idCount(full.GetIDCount()), ordinalCount(full.GetOrdinalCount()) {
+    for (uint32_t id = 0; id < std::max(idCount, base->GetIDCount()); ++id) {
+      uint32_t ordinal = full.FindOrdinal(id);
+      if (ordinal != base->FindOrdinal(id)) {
+        idToOrdinalDelta.emplace_back(id, ordinal);
+      }
+    }
+
+    for (uint32_t ordinal = 0; ordinal < std::max(ordinalCount, base->GetOrdinalCount()); ++ordinal) {
+      uint32_t id = full.FindID(ordinal);
+      if (id != base->FindID(ordinal)) {
+        ordinalToIDDelta.emplace_back(ordinal, id);
+      }
+    }
+  }
+
+  uint32_t VersionRegistry::FindOrdinal(uint32_t id) const {
+    if (base) {
+      auto override = std::lower_bound(idToOrdinalDelta.begin(), idToOrdinalDelta.end(), std::make_pair(id, 0U));
+      if (override != idToOrdinalDelta.end() && override->first == id) {
+        return override->second;
+      }
+
+      return id < idCount ? base->FindOrdinal(id) : UNREGISTERED;
+    }
+
+    // Both maps are padded with zeroes on resize, so only ids surviving the round trip were actually registered.
+    if (id < idToOrdinalMap.size() && idToOrdinalMap[id] < ordinalToIDMap.size() && ordinalToIDMap[idToOrdinalMap[id]] == id) {
+      return idToOrdinalMap[id];
+    }
+
+    return UNREGISTERED;
+  }
+
+  uint32_t VersionRegistry::FindID(uint32_t ordinal) const {
+    if (base) {
+      auto override = std::lower_bound(ordinalToIDDelta.begin(), ordinalToIDDelta.end(), std::make_pair(ordinal, 0U));
+      if (override != ordinalToIDDelta.end() && override->first == ordinal) {
+        return override->second;
+      }
+
+      return ordinal < ordinalCount ? base->FindID(ordinal) : UNREGISTERED;
+    }
+
+    if (ordinal < ordinalToIDMap.size() && ordinalToIDMap[ordinal] < idToOrdinalMap.size() && idToOrdinalMap[ordinalToIDMap[ordinal]] == ordinal) {
+      return ordinalToIDMap[ordinal];
+    }
+
+    return UNREGISTERED;
+  }
+
   Errorable<uint32_t> VersionRegistry::GetOrdinalByID(uint32_t id) const {
+    if (base) {
+      uint32_t ordinal = FindOrdinal(id);
+      if (ordinal == UNREGISTERED) {
+        return InvalidPacketById(id);
+      }
+
+      return SuccessErrorable<uint32_t>(ordinal);
+    }
+
     if (id >= idToOrdinalMap.size()) {
       return InvalidPacketById(id);
     }
@@ -21,6 +89,15 @@ namespace Ship {
   }
 
   Errorable<uint32_t> VersionRegistry::GetIDByOrdinal(uint32_t ordinal) const {
+    if (base) {
+      uint32_t id = FindID(ordinal);
+      if (id == UNREGISTERED) {
+        return InvalidPacketByOrdinal(ordinal);
+      }
+
+      return SuccessErrorable<uint32_t>(id);
+    }
+
     if (ordinal >= ordinalToIDMap.size()) {
       return InvalidPacketByOrdinal(ordinal);
     }
@@ -28,6 +105,102 @@ namespace Ship {
     return SuccessErrorable<uint32_t>(ordinalToIDMap[ordinal]);
   }
 
+  bool VersionRegistry::IsRegisteredID(uint32_t id) const {
+    return FindOrdinal(id) != UNREGISTERED;
+  }
+
+  size_t VersionRegistry::GetIDCount() const {
+    return base ? idCount : idToOrdinalMap.size();
+  }
+
+  size_t VersionRegistry::GetOrdinalCount() const {
+    return base ? ordinalCount : ordinalToIDMap.size();
+  }
+
+  bool VersionRegistry::IsDelta() const {
+    return base != nullptr;
+  }
+
+  const VersionRegistry* VersionRegistry::GetBase() const {
+    return base.get();
+  }
+
+  size_t VersionRegistry::GetMemoryBytes() const {
+    return sizeof(VersionRegistry) + (ordinalToIDMap.capacity() + idToOrdinalMap.capacity()) * sizeof(uint32_t)
+         + (idToOrdinalDelta.capacity() + ordinalToIDDelta.capacity()) * sizeof(std::pair<uint32_t, uint32_t>);
+  }
+
+  size_t VersionRegistry::ContentHash() const {
+    size_t hash = 14695981039346656037ULL;
+    for (uint32_t id = 0; id < GetIDCount(); ++id) {
+      uint32_t ordinal = FindOrdinal(id);
+      if (ordinal != UNREGISTERED) {
+        hash = (hash ^ (((uint64_t) id << 32) | ordinal)) * 1099511628211ULL;
+      }
+    }
+
+    return hash;
+  }
+
+  bool VersionRegistry::ContentEquals(const VersionRegistry& other) const {
+    for (uint32_t id = 0; id < std::max(GetIDCount(), other.GetIDCount()); ++id) {
+      if (FindOrdinal(id) != other.FindOrdinal(id)) {
+        return false;
+      }
+    }
+
+    for (uint32_t ordinal = 0; ordinal < std::max(GetOrdinalCount(), other.GetOrdinalCount()); ++ordinal) {
+      if (FindID(ordinal) != other.FindID(ordinal)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  std::shared_ptr<const VersionRegistry> VersionRegistry::Intern(const std::shared_ptr<const VersionRegistry>& registry) {
+    size_t hash = registry->ContentHash();
+    std::lock_guard<std::mutex> lock(internMutex);
+
+    auto range = internedRegistries.equal_range(hash);
+    for (auto it = range.first; it != range.second;) {
+      std::shared_ptr<const VersionRegistry> interned = it->second.lock();
+      if (!interned) {
+        it = internedRegistries.erase(it);
+        continue;
+      }
+
+      if (interned == registry || interned->ContentEquals(*registry)) {
+        return interned;
+      }
+
+      ++it;
+    }
+
+    internedRegistries.emplace(hash, registry);
+    return registry;
+  }
+
+  std::shared_ptr<const VersionRegistry> VersionRegistry::Diff(const std::shared_ptr<const VersionRegistry>& base_registry,
+    const std::shared_ptr<const VersionRegistry>& full) {
+    if (!base_registry || full->IsDelta()) {
+      return full;
+    }
+
+    // Deltas are always taken against a full registry, so a lookup never walks more than one level.
+    const std::shared_ptr<const VersionRegistry>& root = base_registry->IsDelta() ? base_registry->base : base_registry;
+    if (root == full) {
+      return full;
+    }
+
+    std::shared_ptr<const VersionRegistry> delta(new VersionRegistry(root, *full));
+    if (delta->GetMemoryBytes() >= full->GetMemoryBytes()) {
+      return full;
+    }
+
+    return delta;
+  }
+
   void VersionRegistry::Register(uint32_t ordinal) {
     Register(ordinal, ++latestRegisteredID);
   }
@@ -36,4 +209,4 @@ namespace Ship {
     OrdinalVector::ResizeVectorAndSet(ordinalToIDMap, ordinal, id);
     OrdinalVector::ResizeVectorAndSet(idToOrdinalMap, id, ordinal);
   }
-}
\ No newline at end of file
+}
@@ -3,6 +3,7 @@
 #include "../../utils/ordinal/OrdinalRegistry.hpp"
 #include "../../utils/ordinal/OrdinalVector.hpp"
 #include "../Protocol.hpp"
+#include <memory>
 #include <vector>
 
 namespace Ship {
@@ -11,10 +12,24 @@ namespace Ship {
 
   class VersionRegistry {
    private:
+    static const uint32_t UNREGISTERED;
+
     std::vector<uint32_t> ordinalToIDMap = std::vector<uint32_t>();
     std::vector<uint32_t> idToOrdinalMap = std::vector<uint32_t>();
     int latestRegisteredID = -1;
 
+    // Delta form: sorted (key, value) overrides on top of a full base registry, UNREGISTERED values hide base entries.
+    std::shared_ptr<const VersionRegistry> base;
+    std::vector<std::pair<uint32_t, uint32_t>> idToOrdinalDelta;
+    std::vector<std::pair<uint32_t, uint32_t>> ordinalToIDDelta;
+    size_t idCount = 0;
+    size_t ordinalCount = 0;
+
+    VersionRegistry(std::shared_ptr<const VersionRegistry> base_registry, const VersionRegistry& full);
+
+    [[nodiscard]] uint32_t FindOrdinal(uint32_t id) const;
+    [[nodiscard]] uint32_t FindID(uint32_t ordinal) const;
+
    public:
     VersionRegistry() = default;
 
@@ -33,5 +48,21 @@ namespace Ship {
     void Register(uint32_t ordinal, uint32_t id);
     [[nodiscard]] Errorable<uint32_t> GetOrdinalByID(uint32_t id) const;
     [[nodiscard]] Errorable<uint32_t> GetIDByOrdinal(uint32_t ordinal) const;
+    [[nodiscard]] bool IsRegisteredID(uint32_t id) const;
+    [[nodiscard]] size_t GetIDCount() const;
+    [[nodiscard]] size_t GetOrdinalCount() const;
+
+    [[nodiscard]] bool IsDelta() const;
+    [[nodiscard]] const VersionRegistry* GetBase() const;
+    [[nodiscard]] size_t GetMemoryBytes() const;
+    [[nodiscard]] size_t ContentHash() const;
+    [[nodiscard]] bool ContentEquals(const VersionRegistry& other) const;
+
+    // Returns a shared registry with the same content, the passed one is kept and shared when no equal one exists yet.
+    // Interned registries must not be modified anymore.
+    static std::shared_ptr<const VersionRegistry> Intern(const std::shared_ptr<const VersionRegistry>& registry);
+    // Returns a delta against base when that takes less memory, otherwise the full registry itself.
+    static std::shared_ptr<const VersionRegistry> Diff(const std::shared_ptr<const VersionRegistry>& base_registry,
+      const std::shared_ptr<const VersionRegistry>& full);
   };
-}
\ No newline at end of file
+}
@@ -1,4 +1,5 @@
 #include "VersionedRegistry.hpp"
+#include <unordered_set>
 
 namespace Ship {
   VersionedRegistry::VersionedRegistry(const ProtocolVersions& versions, const std::set<ProtocolVersion>& versionMap)
@@ -12,17 +13,73 @@ namespace Ship {
     }
 
     std::fill(versionToOrdinalMap + previousIt->GetOrdinal(), versionToOrdinalMap + versions.GetMaximumVersion().GetOrdinal() + 1, ordinal);
-    versionRegistry = new VersionRegistry*[VersionToOrdinal(&versions.GetMaximumVersion()) + 1];
+    versionRegistry.resize(VersionToOrdinal(&versions.GetMaximumVersion()) + 1);
+  }
+
+  std::shared_ptr<const VersionRegistry> VersionedRegistry::Adopt(VersionRegistry* registry) const {
+    for (const auto& registered : versionRegistry) {
+      if (registered.get() == registry) {
+        return registered;
+      }
+    }
+
+    return std::shared_ptr<const VersionRegistry>(registry);
   }
 
   void VersionedRegistry::RegisterVersion(const ProtocolVersion* version, VersionRegistry* registry) {
-    versionRegistry[VersionToOrdinal(version)] = registry;
+    versionRegistry[VersionToOrdinal(version)] = Adopt(registry);
   }
 
   void VersionedRegistry::FillVersionRegistry(VersionRegistry* registry) {
+    std::shared_ptr<const VersionRegistry> adopted = Adopt(registry);
     for (uint32_t i = VersionToOrdinal(&versions.GetMinimumVersion()); i <= VersionToOrdinal(&versions.GetMaximumVersion()); ++i) {
-      versionRegistry[i] = registry;
+      versionRegistry[i] = adopted;
+    }
+  }
+
+  void VersionedRegistry::Compact() {
+    for (auto& registry : versionRegistry) {
+      if (registry && !registry->IsDelta()) {
+        registry = VersionRegistry::Intern(registry);
+      }
+    }
+
+    std::shared_ptr<const VersionRegistry> previous;
+    std::shared_ptr<const VersionRegistry> previousCompacted;
+    for (auto& registry : versionRegistry) {
+      if (!registry) {
+        continue;
+      }
+
+      if (registry == previous) {
+        registry = previousCompacted;
+        continue;
+      }
+
+      previous = registry;
+      registry = VersionRegistry::Diff(previousCompacted, registry);
+      previousCompacted = registry;
+    }
+  }
+
+  RegistryMemorySummary VersionedRegistry::GetMemorySummary() const {
+    RegistryMemorySummary summary {versionRegistry.size(), 0, 0, 0, 0};
+    std::unordered_set<const VersionRegistry*> counted;
+    for (const auto& registry : versionRegistry) {
+      for (const VersionRegistry* current = registry.get(); current && counted.insert(current).second; current = current->GetBase()) {
+        ++summary.distinctRegistries;
+        summary.deltaRegistries += current->IsDelta();
+        summary.registryBytes += current->GetMemoryBytes();
+      }
+    }
+
+    summary.tableBytes = (versions.GetMaximumVersion().GetOrdinal() + 1) * sizeof(uint32_t)
+                       + versionRegistry.capacity() * sizeof(std::shared_ptr<const VersionRegistry>);
+    for (const auto& table : remapTables) {
+      summary.tableBytes += sizeof(IdRemapTable) + table.second->GetSize() * sizeof(uint32_t);
     }
+
+    return summary;
   }
 
   Errorable<uint32_t> VersionedRegistry::GetOrdinalByID(const ProtocolVersion* version, uint32_t id) const {
@@ -33,6 +90,47 @@ namespace Ship {
     return versionRegistry[VersionToOrdinal(version)]->GetIDByOrdinal(ordinal);
   }
 
+  void VersionedRegistry::BuildRemapTables() {
+    for (const auto& table : remapTables) {
+      delete table.second;
+    }
+
+    remapTables.clear();
+    std::set<const VersionRegistry*> registries;
+    for (const auto& registry : versionRegistry) {
+      if (registry) {
+        registries.insert(registry.get());
+      }
+    }
+
+    for (const VersionRegistry* source : registries) {
+      for (const VersionRegistry* target : registries) {
+        if (source != target) {
+          remapTables[{source, target}] = new IdRemapTable(source, target);
+        }
+      }
+    }
+  }
+
+  const IdRemapTable* VersionedRegistry::GetRemapTable(const ProtocolVersion* source, const ProtocolVersion* target) const {
+    const VersionRegistry* sourceRegistry = GetVersionRegistry(source);
+    const VersionRegistry* targetRegistry = GetVersionRegistry(target);
+    if (sourceRegistry == targetRegistry) {
+      return nullptr;
+    }
+
+    auto table = remapTables.find({sourceRegistry, targetRegistry});
+    return table == remapTables.end() ? nullptr : table->second;
+  }
+
+  const ProtocolVersions& VersionedRegistry::GetVersions() const {
+    return versions;
+  }
+
+  const VersionRegistry* VersionedRegistry::GetVersionRegistry(const ProtocolVersion* version) const {
+    return versionRegistry[VersionToOrdinal(version)].get();
+  }
+
   uint32_t VersionedRegistry::VersionToOrdinal(const ProtocolVersion* version) const {
     if (version == &ProtocolVersion::UNKNOWN) {
       version = &versions.GetMaximumVersion();
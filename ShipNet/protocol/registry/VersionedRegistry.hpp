@@ -1,32 +1,60 @@
 #pragma once
 
+#include "IdRemapTable.hpp"
 #include "VersionRegistry.hpp"
+#include <map>
 #include <set>
 
 namespace Ship {
+  struct RegistryMemorySummary {
+    size_t versionBuckets;
+    size_t distinctRegistries;
+    size_t deltaRegistries;
+    size_t registryBytes;
+    size_t tableBytes;
+  };
+
   class VersionedRegistry {
    private:
     const ProtocolVersions& versions;
     uint32_t* versionToOrdinalMap;
-    VersionRegistry** versionRegistry;
+    std::vector<std::shared_ptr<const VersionRegistry>> versionRegistry;
+    std::map<std::pair<const VersionRegistry*, const VersionRegistry*>, IdRemapTable*> remapTables;
+
+    std::shared_ptr<const VersionRegistry> Adopt(VersionRegistry* registry) const;
 
    public:
     explicit VersionedRegistry(const ProtocolVersions& versions, const std::set<ProtocolVersion>& versionMap);
 
     virtual ~VersionedRegistry() {
-      if (versionRegistry) {
-        for (uint32_t i = 0; i < VersionToOrdinal(&versions.GetMaximumVersion()) + 1; ++i) {
-          delete versionRegistry[i];
-        }
+      for (const auto& table : remapTables) {
+        delete table.second;
       }
 
-      delete[] versionRegistry;
+      delete[] versionToOrdinalMap;
     }
 
     uint32_t VersionToOrdinal(const ProtocolVersion* version) const;
     Errorable<uint32_t> GetOrdinalByID(const ProtocolVersion* version, uint32_t id) const;
     Errorable<uint32_t> GetIDByOrdinal(const ProtocolVersion* version, uint32_t ordinal) const;
+    // Both take ownership of the registry, the same registry may be passed for several versions. It stays usable by the caller,
+    // and may still be modified, until Compact.
     void RegisterVersion(const ProtocolVersion* version, VersionRegistry* registry);
     void FillVersionRegistry(VersionRegistry* registry);
+
+    // Freezes the registration: interns the registries, so equal mappings are stored once across all registries, and replaces
+    // them by deltas against the previous version where that is smaller. Registered pointers may be released by it and must not
+    // be used afterwards.
+    void Compact();
+    [[nodiscard]] RegistryMemorySummary GetMemorySummary() const;
+
+    // Precomputes id translation for every pair of distinct registries, versions sharing a registry share its tables. Has to be
+    // called again after registering new versions.
+    void BuildRemapTables();
+
+    [[nodiscard]] const ProtocolVersions& GetVersions() const;
+    [[nodiscard]] const VersionRegistry* GetVersionRegistry(const ProtocolVersion* version) const;
+    // nullptr when both versions use the same registry and ids need no remapping, or when the tables weren't built.
+    [[nodiscard]] const IdRemapTable* GetRemapTable(const ProtocolVersion* source, const ProtocolVersion* target) const;
   };
 }
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace Ship {
+  class Log2Histogram {
+   public:
+    static const uint32_t BUCKET_COUNT = 32;
+
+   private:
+    std::array<uint64_t, BUCKET_COUNT> buckets {};
+    uint64_t count = 0;
+
+   public:
+    // Bucket N holds values in [2^N, 2^(N + 1)), zero goes to the first bucket.
+    void Record(uint64_t value) {
+      uint32_t bucket = value == 0 ? 0 : 63 - __builtin_clzll(value);
+      ++buckets[bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1];
+      ++count;
+    }
+
+    void Reset() {
+      buckets.fill(0);
+      count = 0;
+    }
+
+    [[nodiscard]] uint64_t GetBucket(uint32_t bucket) const {
+      return buckets[bucket];
+    }
+
+    [[nodiscard]] const std::array<uint64_t, BUCKET_COUNT>& GetBuckets() const {
+      return buckets;
+    }
+
+    [[nodiscard]] uint64_t GetCount() const {
+      return count;
+    }
+  };
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Ship {
+  class OrdinalBitmap {
+   private:
+    std::vector<uint64_t> words;
+
+   public:
+    void Set(uint32_t ordinal) {
+      if ((ordinal >> 6) >= words.size()) {
+        words.resize((ordinal >> 6) + 1);
+      }
+
+      words[ordinal >> 6] |= 1ULL << (ordinal & 63);
+    }
+
+    [[nodiscard]] bool Test(uint32_t ordinal) const {
+      return (ordinal >> 6) < words.size() && (words[ordinal >> 6] >> (ordinal & 63) & 1) != 0;
+    }
+
+    void Clear() {
+      words.clear();
+    }
+  };
+}
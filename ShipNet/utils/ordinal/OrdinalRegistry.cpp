@@ -14,6 +14,15 @@ namespace Ship {
     return ordinal;
   }
 
+  uint32_t OrdinalRegistry::RegisterOrdinals(uint32_t count) {
+    mtx.lock();
+    uint32_t ordinal = counter;
+    counter += count;
+    mtx.unlock();
+
+    return ordinal;
+  }
+
   uint32_t OrdinalRegistry::GetLastOrdinal() const {
     return counter;
   }
@@ -17,6 +17,8 @@ namespace Ship {
     static OrdinalRegistry ErrorableTypeRegistry;
 
     uint32_t RegisterOrdinal();
+    // Reserves count consecutive ordinals and returns the first one.
+    uint32_t RegisterOrdinals(uint32_t count);
 
     [[nodiscard]] uint32_t GetLastOrdinal() const;
   };
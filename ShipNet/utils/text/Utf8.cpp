@@ -0,0 +1,272 @@
+#include "Utf8.hpp"
+#include <algorithm>
+#include <cstring>
+#if defined(__x86_64__) || defined(__SSE2__)
+  #include <immintrin.h>
+#endif
+
+namespace Ship {
+  // Decodes one non-ASCII sequence at the given offset, returns its length in bytes or 0 when it is malformed.
+  static inline size_t DecodeSequence(const uint8_t* bytes, size_t size, size_t offset) {
+    uint8_t lead = bytes[offset];
+    size_t length;
+    uint8_t minimum = 0x80;
+    uint8_t maximum = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      length = 3;
+      // Overlong encodings and UTF-16 surrogates.
+      minimum = lead == 0xE0 ? 0xA0 : 0x80;
+      maximum = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      length = 4;
+      // Overlong encodings and code points above U+10FFFF.
+      minimum = lead == 0xF0 ? 0x90 : 0x80;
+      maximum = lead == 0xF4 ? 0x8F : 0xBF;
+    } else {
+      return 0;
+    }
+
+    if (size - offset < length || bytes[offset + 1] < minimum || bytes[offset + 1] > maximum) {
+      return 0;
+    }
+
+    for (size_t i = 2; i < length; ++i) {
+      if ((bytes[offset + i] & 0xC0) != 0x80) {
+        return 0;
+      }
+    }
+
+    return length;
+  }
+
+#if defined(__x86_64__)
+  // Lookup tables of the block validator, after Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte".
+  // Every error class gets a bit, the nibbles of a byte pair select the classes they could belong to and a pair is malformed
+  // when all three lookups agree on one. Sequences longer than two bytes are checked through the bytes two and three back.
+  static const uint8_t TOO_SHORT = 1 << 0;
+  static const uint8_t TOO_LONG = 1 << 1;
+  static const uint8_t OVERLONG_3 = 1 << 2;
+  static const uint8_t TOO_LARGE = 1 << 3;
+  static const uint8_t SURROGATE = 1 << 4;
+  static const uint8_t OVERLONG_2 = 1 << 5;
+  static const uint8_t TOO_LARGE_1000 = 1 << 6;
+  static const uint8_t OVERLONG_4 = 1 << 6;
+  static const uint8_t TWO_CONTS = 1 << 7;
+  static const uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+  // Indexed by the high nibble of the first byte of a pair.
+  alignas(16) static const uint8_t FIRST_HIGH_TABLE[16] = {TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS, TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE,
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4};
+  // Indexed by the low nibble of the first byte.
+  alignas(16) static const uint8_t FIRST_LOW_TABLE[16] = {CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY,
+    CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000};
+  // Indexed by the high nibble of the second byte.
+  alignas(16) static const uint8_t SECOND_HIGH_TABLE[16] = {TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    TOO_SHORT, TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE, TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT};
+  // A block ending in a lead byte whose sequence doesn't fit anymore exceeds these in its last three bytes.
+  alignas(16) static const uint8_t INCOMPLETE_TABLE[32] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF};
+
+  // Both validate whole blocks and count their units as one per byte that isn't a continuation plus one per four-byte lead.
+  // The tail is padded with zeros, which validate as ASCII and are taken off the count again. False on malformed input.
+  __attribute__((target("ssse3"))) static bool CountUtf16UnitsSsse3(const uint8_t* bytes, size_t size, size_t* units) {
+    const __m128i firstHighTable = _mm_load_si128((const __m128i*) FIRST_HIGH_TABLE);
+    const __m128i firstLowTable = _mm_load_si128((const __m128i*) FIRST_LOW_TABLE);
+    const __m128i secondHighTable = _mm_load_si128((const __m128i*) SECOND_HIGH_TABLE);
+    const __m128i incompleteLimit = _mm_loadu_si128((const __m128i*) (INCOMPLETE_TABLE + 16));
+    const __m128i lowNibble = _mm_set1_epi8(0x0F);
+    __m128i previous = _mm_setzero_si128();
+    __m128i previousIncomplete = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+    size_t count = 0;
+
+    uint8_t tail[16] = {};
+    size_t tailSize = size % 16;
+    std::memcpy(tail, bytes + size - tailSize, tailSize);
+    for (size_t offset = 0; offset < size; offset += 16) {
+      const uint8_t* block = size - offset >= 16 ? bytes + offset : tail;
+      __m128i input = _mm_loadu_si128((const __m128i*) block);
+      if (_mm_movemask_epi8(input) == 0) {
+        error = _mm_or_si128(error, previousIncomplete);
+        previousIncomplete = _mm_setzero_si128();
+        count += 16;
+      } else {
+        __m128i first = _mm_alignr_epi8(input, previous, 15);
+        __m128i special = _mm_and_si128(_mm_and_si128(_mm_shuffle_epi8(firstHighTable, _mm_and_si128(_mm_srli_epi16(first, 4), lowNibble)),
+                                          _mm_shuffle_epi8(firstLowTable, _mm_and_si128(first, lowNibble))),
+          _mm_shuffle_epi8(secondHighTable, _mm_and_si128(_mm_srli_epi16(input, 4), lowNibble)));
+        __m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, previous, 14), _mm_set1_epi8((char) (0xE0 - 0x80)));
+        __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, previous, 13), _mm_set1_epi8((char) (0xF0 - 0x80)));
+        __m128i mustContinue = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char) 0x80));
+        error = _mm_or_si128(error, _mm_xor_si128(mustContinue, special));
+        previousIncomplete = _mm_subs_epu8(input, incompleteLimit);
+
+        int leads = _mm_movemask_epi8(_mm_cmpgt_epi8(input, _mm_set1_epi8(-65)));
+        int fourByteLeads = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(input, _mm_set1_epi8((char) 0xF0)), input));
+        count += __builtin_popcount(leads) + __builtin_popcount(fourByteLeads);
+      }
+
+      previous = input;
+    }
+
+    error = _mm_or_si128(error, previousIncomplete);
+    *units = count - (tailSize != 0 ? 16 - tailSize : 0);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+  }
+
+  __attribute__((target("avx2"))) static bool CountUtf16UnitsAvx2(const uint8_t* bytes, size_t size, size_t* units) {
+    const __m256i firstHighTable = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*) FIRST_HIGH_TABLE));
+    const __m256i firstLowTable = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*) FIRST_LOW_TABLE));
+    const __m256i secondHighTable = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*) SECOND_HIGH_TABLE));
+    const __m256i incompleteLimit = _mm256_loadu_si256((const __m256i*) INCOMPLETE_TABLE);
+    const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+    __m256i previous = _mm256_setzero_si256();
+    __m256i previousIncomplete = _mm256_setzero_si256();
+    __m256i error = _mm256_setzero_si256();
+    size_t count = 0;
+
+    uint8_t tail[32] = {};
+    size_t tailSize = size % 32;
+    std::memcpy(tail, bytes + size - tailSize, tailSize);
+    for (size_t offset = 0; offset < size; offset += 32) {
+      const uint8_t* block = size - offset >= 32 ? bytes + offset : tail;
+      __m256i input = _mm256_loadu_si256((const __m256i*) block);
+      if (_mm256_movemask_epi8(input) == 0) {
+        error = _mm256_or_si256(error, previousIncomplete);
+        previousIncomplete = _mm256_setzero_si256();
+        count += 32;
+      } else {
+        // The bytes before each position, the lower lane takes them from the upper lane of the previous block.
+        __m256i carried = _mm256_permute2x128_si256(previous, input, 0x21);
+        __m256i first = _mm256_alignr_epi8(input, carried, 15);
+        __m256i special = _mm256_and_si256(
+          _mm256_and_si256(_mm256_shuffle_epi8(firstHighTable, _mm256_and_si256(_mm256_srli_epi16(first, 4), lowNibble)),
+            _mm256_shuffle_epi8(firstLowTable, _mm256_and_si256(first, lowNibble))),
+          _mm256_shuffle_epi8(secondHighTable, _mm256_and_si256(_mm256_srli_epi16(input, 4), lowNibble)));
+        __m256i third = _mm256_subs_epu8(_mm256_alignr_epi8(input, carried, 14), _mm256_set1_epi8((char) (0xE0 - 0x80)));
+        __m256i fourth = _mm256_subs_epu8(_mm256_alignr_epi8(input, carried, 13), _mm256_set1_epi8((char) (0xF0 - 0x80)));
+        __m256i mustContinue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char) 0x80));
+        error = _mm256_or_si256(error, _mm256_xor_si256(mustContinue, special));
+        previousIncomplete = _mm256_subs_epu8(input, incompleteLimit);
+
+        auto leads = (uint32_t) _mm256_movemask_epi8(_mm256_cmpgt_epi8(input, _mm256_set1_epi8(-65)));
+        auto fourByteLeads = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(input, _mm256_set1_epi8((char) 0xF0)), input));
+        count += __builtin_popcount(leads) + __builtin_popcount(fourByteLeads);
+      }
+
+      previous = input;
+    }
+
+    error = _mm256_or_si256(error, previousIncomplete);
+    *units = count - (tailSize != 0 ? 32 - tailSize : 0);
+    return _mm256_testz_si256(error, error) != 0;
+  }
+
+  static bool HasAvx2() {
+    static const bool hasAvx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return hasAvx2;
+  }
+
+  static bool HasSsse3() {
+    static const bool hasSsse3 = (__builtin_cpu_init(), __builtin_cpu_supports("ssse3"));
+    return hasSsse3;
+  }
+#endif
+
+  size_t Utf8::SkipAscii(const uint8_t* bytes, size_t size) {
+    size_t offset = 0;
+#if defined(__SSE2__)
+    for (; offset + 16 <= size; offset += 16) {
+      if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*) (bytes + offset))) != 0) {
+        return offset;
+      }
+    }
+#endif
+    for (; offset + 8 <= size; offset += 8) {
+      uint64_t word;
+      std::memcpy(&word, bytes + offset, sizeof(word));
+      if ((word & 0x8080808080808080ULL) != 0) {
+        return offset;
+      }
+    }
+
+    return offset;
+  }
+
+  Errorable<uint32_t> Utf8::CountUtf16Units(const uint8_t* bytes, size_t size) {
+#if defined(__x86_64__)
+    // Shorter strings don't fill a block, the padding would cost more than the scalar loop.
+    if (size >= 16 && (HasAvx2() || HasSsse3())) {
+      size_t units;
+      bool valid = HasAvx2() ? CountUtf16UnitsAvx2(bytes, size, &units) : CountUtf16UnitsSsse3(bytes, size, &units);
+      if (valid) {
+        return SuccessErrorable<uint32_t>(units);
+      }
+
+      // Blocks only tell that something is malformed, the reference finds the offset.
+      return CountUtf16UnitsScalar(bytes, size);
+    }
+#endif
+
+    size_t offset = 0;
+    size_t units = 0;
+    while (offset < size) {
+      if (bytes[offset] < 0x80) {
+        // Whole ASCII blocks are one unit per byte. They are only skipped once the next word is ASCII, short runs between
+        // multi-byte characters are cheaper to step over than to dispatch for.
+        uint64_t word;
+        if (size - offset >= sizeof(word) && (std::memcpy(&word, bytes + offset, sizeof(word)), (word & 0x8080808080808080ULL) == 0)) {
+          size_t ascii = SkipAscii(bytes + offset, size - offset);
+          offset += ascii;
+          units += ascii;
+        }
+
+        for (; offset < size && bytes[offset] < 0x80; ++offset) {
+          ++units;
+        }
+
+        continue;
+      }
+
+      size_t length = DecodeSequence(bytes, size, offset);
+      if (length == 0) {
+        return InvalidUtf8Errorable(offset);
+      }
+
+      offset += length;
+      units += length == 4 ? 2 : 1;
+    }
+
+    return SuccessErrorable<uint32_t>(units);
+  }
+
+  Errorable<uint32_t> Utf8::CountUtf16UnitsScalar(const uint8_t* bytes, size_t size) {
+    size_t offset = 0;
+    size_t units = 0;
+    while (offset < size) {
+      if (bytes[offset] < 0x80) {
+        ++offset;
+        ++units;
+        continue;
+      }
+
+      size_t length = DecodeSequence(bytes, size, offset);
+      if (length == 0) {
+        return InvalidUtf8Errorable(offset);
+      }
+
+      offset += length;
+      units += length == 4 ? 2 : 1;
+    }
+
+    return SuccessErrorable<uint32_t>(units);
+  }
+}
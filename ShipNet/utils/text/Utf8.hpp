@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../exception/Errorable.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace Ship {
+  CreateInvalidArgumentErrorable(InvalidUtf8Errorable, uint32_t, "Malformed UTF-8 sequence, byte offset");
+
+  class Utf8 {
+   private:
+    static size_t SkipAscii(const uint8_t* bytes, size_t size);
+
+   public:
+    // Validates the bytes as UTF-8 and counts the UTF-16 code units they encode, which is what protocol string limits refer to.
+    static Errorable<uint32_t> CountUtf16Units(const uint8_t* bytes, size_t size);
+    // Byte-at-a-time reference of CountUtf16Units.
+    static Errorable<uint32_t> CountUtf16UnitsScalar(const uint8_t* bytes, size_t size);
+  };
+}
@@ -0,0 +1,107 @@
+#include "Epoch.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Ship {
+  class alignas(64) ReaderSlot {
+   public:
+    std::atomic<uint64_t> epoch {0};
+    std::atomic<bool> claimed {false};
+  };
+
+  class ThreadReader {
+   public:
+    ReaderSlot* slot = nullptr;
+    uint32_t depth = 0;
+
+    ~ThreadReader() {
+      if (slot) {
+        slot->claimed.store(false, std::memory_order_release);
+      }
+    }
+  };
+
+  static ReaderSlot readerSlots[Epoch::MAX_READERS];
+  static std::atomic<uint64_t> globalEpoch {1};
+  static std::mutex retiredMutex;
+  static std::vector<std::pair<uint64_t, std::function<void()>>> retired;
+  static thread_local ThreadReader threadReader;
+
+  static ReaderSlot* ClaimSlot() {
+    while (true) {
+      for (ReaderSlot& slot : readerSlots) {
+        bool expected = false;
+        if (!slot.claimed.load(std::memory_order_relaxed) && slot.claimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+          return &slot;
+        }
+      }
+
+      std::this_thread::yield();
+    }
+  }
+
+  Epoch::ReadGuard::ReadGuard() {
+    if (threadReader.depth++ == 0) {
+      if (!threadReader.slot) {
+        threadReader.slot = ClaimSlot();
+      }
+
+      // Sequentially consistent, so a writer either sees this slot or the reader sees the newly published object.
+      threadReader.slot->epoch.store(globalEpoch.load());
+    }
+  }
+
+  Epoch::ReadGuard::~ReadGuard() {
+    if (--threadReader.depth == 0) {
+      threadReader.slot->epoch.store(0, std::memory_order_release);
+    }
+  }
+
+  void Epoch::Retire(std::function<void()> deleter) {
+    uint64_t retireEpoch = globalEpoch.fetch_add(1) + 1;
+    {
+      std::lock_guard<std::mutex> lock(retiredMutex);
+      retired.emplace_back(retireEpoch, std::move(deleter));
+    }
+
+    Reclaim();
+  }
+
+  void Epoch::Reclaim() {
+    uint64_t oldestEpoch = UINT64_MAX;
+    for (ReaderSlot& slot : readerSlots) {
+      uint64_t epoch = slot.epoch.load();
+      if (epoch != 0 && epoch < oldestEpoch) {
+        oldestEpoch = epoch;
+      }
+    }
+
+    std::vector<std::function<void()>> deleters;
+    {
+      std::lock_guard<std::mutex> lock(retiredMutex);
+      std::vector<std::pair<uint64_t, std::function<void()>>> remaining;
+      for (auto& entry : retired) {
+        if (entry.first <= oldestEpoch) {
+          deleters.push_back(std::move(entry.second));
+        } else {
+          remaining.push_back(std::move(entry));
+        }
+      }
+
+      retired.swap(remaining);
+    }
+
+    for (auto& deleter : deleters) {
+      deleter();
+    }
+  }
+
+  size_t Epoch::GetPendingCount() {
+    std::lock_guard<std::mutex> lock(retiredMutex);
+    return retired.size();
+  }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace Ship {
+  // Epoch based grace periods: objects unpublished by writers are deleted once no reader that could still see them is left.
+  class Epoch {
+   public:
+    // Threads reading concurrently at the same time, further readers wait for a slot.
+    static constexpr size_t MAX_READERS = 1024;
+
+    // Marks a read-side critical section, it doesn't block and may be nested.
+    class ReadGuard {
+     public:
+      ReadGuard();
+      ~ReadGuard();
+
+      ReadGuard(const ReadGuard&) = delete;
+      ReadGuard& operator=(const ReadGuard&) = delete;
+    };
+
+    // Has to be called after the object was unpublished, the deleter runs on a later Retire or Reclaim call.
+    static void Retire(std::function<void()> deleter);
+    static void Reclaim();
+    static size_t GetPendingCount();
+  };
+}
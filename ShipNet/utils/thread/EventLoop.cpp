@@ -1,32 +1,80 @@
 #include "EventLoop.hpp"
 #include "../ShipUtils.hpp"
+#include "Offloader.hpp"
+#include <algorithm>
 
 namespace Ship {
-  void EventLoop::Execute(const std::function<void()>& function) {
-    immediateTasks.push(function);
+  static bool LaterDeadline(const DelayedTask& first, const DelayedTask& second) {
+    return first.deadline != second.deadline ? first.deadline > second.deadline : first.sequence > second.sequence;
   }
 
-  void EventLoop::Delay(const std::function<void()>& function, time_t millis) {
-    delayedTasks.emplace_back(ShipUtils::GetCurrentMillis() + millis, function);
+  EventLoop::~EventLoop() {
+    delete offloader;
+  }
+
+  void EventLoop::Execute(Task task) {
+    immediateTasks.Push(std::move(task));
+  }
+
+  void EventLoop::Delay(Task task, time_t millis) {
+    if (delayedTasks.size() == delayedTasks.capacity()) {
+      Task::CountAllocation();
+    }
+
+    delayedTasks.push_back({ShipUtils::GetCurrentMillis() + millis, delayedSequence++, std::move(task)});
+    std::push_heap(delayedTasks.begin(), delayedTasks.end(), LaterDeadline);
+  }
+
+  void EventLoop::Post(Task task) {
+    postedTasksMutex.lock();
+    postedTasks.Push(std::move(task));
+    postedTasksMutex.unlock();
+
+    Wakeup();
   }
 
   void EventLoop::ProceedTasks() {
-    while (!immediateTasks.empty()) {
-      immediateTasks.front()();
-      immediateTasks.pop();
+    postedTasksMutex.lock();
+    postedTasks.Swap(proceedingPostedTasks);
+    postedTasksMutex.unlock();
+
+    while (!proceedingPostedTasks.IsEmpty()) {
+      proceedingPostedTasks.Pop()();
+    }
+
+    while (!immediateTasks.IsEmpty()) {
+      immediateTasks.Pop()();
     }
 
     if (!delayedTasks.empty()) {
-      uint32_t currentTime = ShipUtils::GetCurrentMillis();
+      uint64_t currentTime = ShipUtils::GetCurrentMillis();
+      // Tasks delayed while this loop runs wait for the next call, so a task delaying itself by 0 ms can't keep it spinning.
+      uint64_t sequenceBound = delayedSequence;
 
-      delayedTasks.remove_if([&currentTime](auto& it) {
-        if (it.first <= currentTime) {
-          it.second();
-          return true;
-        }
+      while (!delayedTasks.empty() && delayedTasks.front().deadline <= currentTime && delayedTasks.front().sequence < sequenceBound) {
+        std::pop_heap(delayedTasks.begin(), delayedTasks.end(), LaterDeadline);
+        Task task = std::move(delayedTasks.back().task);
+        delayedTasks.pop_back();
+        task();
+      }
+    }
+  }
 
-        return false;
-      });
+  int64_t EventLoop::GetMillisUntilNextDelayed() const {
+    if (delayedTasks.empty()) {
+      return -1;
     }
+
+    uint64_t currentTime = ShipUtils::GetCurrentMillis();
+    return delayedTasks.front().deadline <= currentTime ? 0 : (int64_t) (delayedTasks.front().deadline - currentTime);
+  }
+
+  void EventLoop::SetOffloader(Offloader* new_offloader) {
+    delete offloader;
+    offloader = new_offloader;
+  }
+
+  Offloader* EventLoop::GetOffloader() const {
+    return offloader;
   }
-}
\ No newline at end of file
+}
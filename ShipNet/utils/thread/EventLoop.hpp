@@ -1,22 +1,49 @@
 #pragma once
 
-#include <functional>
-#include <list>
-#include <queue>
+#include "Task.hpp"
 #include <cstdint>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <vector>
 
 namespace Ship {
+  class Offloader;
+
+  class DelayedTask {
+   public:
+    uint64_t deadline;
+    // Keeps tasks with the same deadline in the order they were delayed.
+    uint64_t sequence;
+    Task task;
+  };
+
   class EventLoop {
    private:
-    std::queue<std::function<void()>> immediateTasks;
-    std::list<std::pair<uint32_t, std::function<void()>>> delayedTasks;
+    TaskRing immediateTasks;
+    // Min-heap by deadline, the vector keeps its capacity so delaying doesn't allocate per task.
+    std::vector<DelayedTask> delayedTasks;
+    uint64_t delayedSequence = 0;
+    std::mutex postedTasksMutex;
+    TaskRing postedTasks;
+    TaskRing proceedingPostedTasks;
+    Offloader* offloader = nullptr;
 
    public:
-    virtual ~EventLoop() = default;
+    virtual ~EventLoop();
 
-    void Execute(const std::function<void()>& function);
-    void Delay(const std::function<void()>& function, time_t millis);
+    void Execute(Task task);
+    void Delay(Task task, time_t millis);
+    void Post(Task task);
     void ProceedTasks();
+    // Milliseconds until the earliest delayed task is due, -1 if there is none.
+    [[nodiscard]] int64_t GetMillisUntilNextDelayed() const;
+
+    void SetOffloader(Offloader* new_offloader);
+    [[nodiscard]] Offloader* GetOffloader() const;
+
+    virtual void Wakeup() {
+    }
 
     virtual void StartLoop() {
     }
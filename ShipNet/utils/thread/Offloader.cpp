@@ -0,0 +1,141 @@
+#include "Offloader.hpp"
+
+namespace Ship {
+  bool OffloadSequence::IsBusy() const {
+    return !entries.empty();
+  }
+
+  void OffloadSequence::Then(const std::function<void()>& completion) {
+    if (entries.empty()) {
+      completion();
+    } else {
+      entries.push_back(std::make_shared<Entry>(Entry {true, completion}));
+    }
+  }
+
+  void OffloadSequence::Drain() {
+    while (!entries.empty() && entries.front()->completed) {
+      std::function<void()> completion = std::move(entries.front()->completion);
+      entries.pop_front();
+      completion();
+    }
+  }
+
+  bool OffloadGuard::Enter() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closed) {
+      return false;
+    }
+
+    ++running;
+    return true;
+  }
+
+  void OffloadGuard::Leave() {
+    std::function<void()> pendingRelease;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--running == 0 && closed) {
+        pendingRelease = std::move(release);
+      }
+    }
+
+    if (pendingRelease) {
+      pendingRelease();
+    }
+  }
+
+  void OffloadGuard::Close(std::function<void()> on_release) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      closed = true;
+      if (running != 0) {
+        release = std::move(on_release);
+        return;
+      }
+    }
+
+    if (on_release) {
+      on_release();
+    }
+  }
+
+  bool OffloadGuard::IsClosed() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return closed;
+  }
+
+  Offloader::Offloader(EventLoop* event_loop, WorkerPool* worker_pool, size_t max_in_flight_bytes)
+    : eventLoop(event_loop), workerPool(worker_pool), maxInFlightBytes(max_in_flight_bytes), link(std::make_shared<OffloaderLink>()) {
+    link->offloader = this;
+  }
+
+  Offloader::~Offloader() {
+    std::lock_guard<std::mutex> lock(link->mutex);
+    link->offloader = nullptr;
+  }
+
+  void Offloader::Offload(
+    const std::shared_ptr<OffloadSequence>& sequence, size_t weight, std::function<void()> work, std::function<void()> completion) {
+    auto entry = std::make_shared<OffloadSequence::Entry>(OffloadSequence::Entry {false, std::move(completion)});
+    sequence->entries.push_back(entry);
+
+    Job job {sequence, entry, weight, std::move(work)};
+    if (inFlightBytes != 0 && inFlightBytes + weight > maxInFlightBytes) {
+      deferredJobs.push_back(std::move(job));
+    } else {
+      Dispatch(std::move(job));
+    }
+  }
+
+  void Offloader::Dispatch(Job job) {
+    inFlightBytes += job.weight;
+    workerPool->Submit([link = link, eventLoop = eventLoop, job = std::move(job)]() {
+      job.work();
+
+      // Loops delete their offloader before tearing anything else down, so holding the lock keeps the loop alive during the post.
+      std::lock_guard<std::mutex> lock(link->mutex);
+      if (link->offloader) {
+        eventLoop->Post([link, job]() {
+          if (link->offloader) {
+            link->offloader->Complete(job);
+          }
+        });
+      }
+    });
+  }
+
+  void Offloader::Complete(const Job& job) {
+    inFlightBytes -= job.weight;
+    job.entry->completed = true;
+
+    std::shared_ptr<OffloadSequence> sequence = job.sequence.lock();
+    if (sequence) {
+      sequence->Drain();
+    }
+
+    while (!deferredJobs.empty()) {
+      Job& nextJob = deferredJobs.front();
+      if (nextJob.sequence.expired()) {
+        deferredJobs.pop_front();
+        continue;
+      }
+
+      if (inFlightBytes != 0 && inFlightBytes + nextJob.weight > maxInFlightBytes) {
+        break;
+      }
+
+      Job dispatchedJob = std::move(nextJob);
+      deferredJobs.pop_front();
+      Dispatch(std::move(dispatchedJob));
+    }
+  }
+
+  size_t Offloader::GetInFlightBytes() const {
+    return inFlightBytes;
+  }
+
+  size_t Offloader::GetDeferredJobCount() const {
+    return deferredJobs.size();
+  }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "EventLoop.hpp"
+#include "WorkerPool.hpp"
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace Ship {
+  // Keeps completions of one connection in submission order. Lives on the owning loop thread only.
+  class OffloadSequence {
+   private:
+    struct Entry {
+      bool completed;
+      std::function<void()> completion;
+    };
+
+    std::deque<std::shared_ptr<Entry>> entries;
+
+    friend class Offloader;
+
+   public:
+    [[nodiscard]] bool IsBusy() const;
+
+    void Then(const std::function<void()>& completion);
+    void Drain();
+  };
+
+  // Lets the loop thread retire an object worker jobs may still use without waiting for them.
+  class OffloadGuard {
+   private:
+    std::mutex mutex;
+    size_t running = 0;
+    bool closed = false;
+    std::function<void()> release;
+
+   public:
+    // Called by the job on its worker, false once the guard is closed and the object must not be touched anymore.
+    bool Enter();
+    void Leave();
+
+    // Jobs that come later skip their work. The release runs right away when no job is inside, otherwise on the worker of the
+    // last job leaving.
+    void Close(std::function<void()> on_release);
+    [[nodiscard]] bool IsClosed();
+  };
+
+  class Offloader;
+
+  // Outlives the Offloader, so workers finishing after it got deleted don't post to its loop.
+  class OffloaderLink {
+   public:
+    std::mutex mutex;
+    Offloader* offloader;
+  };
+
+  class Offloader {
+   private:
+    struct Job {
+      std::weak_ptr<OffloadSequence> sequence;
+      std::shared_ptr<OffloadSequence::Entry> entry;
+      size_t weight;
+      std::function<void()> work;
+    };
+
+    EventLoop* eventLoop;
+    WorkerPool* workerPool;
+    size_t maxInFlightBytes;
+    size_t inFlightBytes = 0;
+    std::deque<Job> deferredJobs;
+    std::shared_ptr<OffloaderLink> link;
+
+    void Dispatch(Job job);
+    void Complete(const Job& job);
+
+   public:
+    Offloader(EventLoop* event_loop, WorkerPool* worker_pool, size_t max_in_flight_bytes);
+    // Has to happen on the loop thread, completions of jobs still running on workers are dropped.
+    ~Offloader();
+
+    void Offload(const std::shared_ptr<OffloadSequence>& sequence, size_t weight, std::function<void()> work, std::function<void()> completion);
+
+    [[nodiscard]] size_t GetInFlightBytes() const;
+    [[nodiscard]] size_t GetDeferredJobCount() const;
+  };
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Ship {
+  // Move-only void() callable, captures up to INLINE_SIZE bytes are stored in place and only bigger ones are heap allocated.
+  class Task {
+   public:
+    static constexpr size_t INLINE_SIZE = 56;
+
+   private:
+    class Operations {
+     public:
+      void (*invoke)(void* storage);
+      void (*move)(void* from, void* to);
+      void (*destroy)(void* storage);
+    };
+
+    template<typename F>
+    static constexpr bool IS_INLINE = sizeof(F) <= INLINE_SIZE && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<F>;
+
+    template<typename F>
+    static inline const Operations INLINE_OPERATIONS = {
+      [](void* storage) {
+        (*std::launder((F*) storage))();
+      },
+      [](void* from, void* to) {
+        new (to) F(std::move(*std::launder((F*) from)));
+        std::launder((F*) from)->~F();
+      },
+      [](void* storage) {
+        std::launder((F*) storage)->~F();
+      }};
+
+    template<typename F>
+    static inline const Operations HEAP_OPERATIONS = {
+      [](void* storage) {
+        (**(F**) storage)();
+      },
+      [](void* from, void* to) {
+        *(F**) to = *(F**) from;
+      },
+      [](void* storage) {
+        delete *(F**) storage;
+      }};
+
+    static inline std::atomic<uint64_t> allocationCount {0};
+
+    alignas(std::max_align_t) unsigned char storage[INLINE_SIZE];
+    const Operations* operations = nullptr;
+
+   public:
+    Task() = default;
+
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& function) { // NOLINT(google-explicit-constructor)
+      using Function = std::decay_t<F>;
+      if constexpr (IS_INLINE<Function>) {
+        new (storage) Function(std::forward<F>(function));
+        operations = &INLINE_OPERATIONS<Function>;
+      } else {
+        *(Function**) storage = new Function(std::forward<F>(function));
+        operations = &HEAP_OPERATIONS<Function>;
+        CountAllocation();
+      }
+    }
+
+    Task(Task&& other) noexcept : operations(other.operations) {
+      if (operations) {
+        operations->move(other.storage, storage);
+        other.operations = nullptr;
+      }
+    }
+
+    Task& operator=(Task&& other) noexcept {
+      if (this != &other) {
+        Reset();
+        operations = other.operations;
+        if (operations) {
+          operations->move(other.storage, storage);
+          other.operations = nullptr;
+        }
+      }
+
+      return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+      Reset();
+    }
+
+    void operator()() {
+      operations->invoke(storage);
+    }
+
+    explicit operator bool() const {
+      return operations != nullptr;
+    }
+
+    void Reset() {
+      if (operations) {
+        operations->destroy(storage);
+        operations = nullptr;
+      }
+    }
+
+    static void CountAllocation() {
+      allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Heap allocations made on behalf of tasks, by oversized captures or by growing task storage.
+    static uint64_t GetAllocationCount() {
+      return allocationCount.load(std::memory_order_relaxed);
+    }
+  };
+
+  // FIFO of tasks in a power of two ring, it only allocates when it has to grow.
+  class TaskRing {
+   private:
+    Task* tasks = nullptr;
+    size_t capacity = 0;
+    size_t head = 0;
+    size_t size = 0;
+
+    void Grow() {
+      size_t newCapacity = capacity == 0 ? 16 : capacity * 2;
+      auto* newTasks = new Task[newCapacity];
+      for (size_t i = 0; i < size; ++i) {
+        newTasks[i] = std::move(tasks[(head + i) & (capacity - 1)]);
+      }
+
+      delete[] tasks;
+      tasks = newTasks;
+      capacity = newCapacity;
+      head = 0;
+      Task::CountAllocation();
+    }
+
+   public:
+    TaskRing() = default;
+
+    ~TaskRing() {
+      delete[] tasks;
+    }
+
+    TaskRing(const TaskRing&) = delete;
+    TaskRing& operator=(const TaskRing&) = delete;
+
+    void Push(Task&& task) {
+      if (size == capacity) {
+        Grow();
+      }
+
+      tasks[(head + size) & (capacity - 1)] = std::move(task);
+      ++size;
+    }
+
+    Task Pop() {
+      Task task = std::move(tasks[head]);
+      head = (head + 1) & (capacity - 1);
+      --size;
+      return task;
+    }
+
+    void Swap(TaskRing& other) {
+      std::swap(tasks, other.tasks);
+      std::swap(capacity, other.capacity);
+      std::swap(head, other.head);
+      std::swap(size, other.size);
+    }
+
+    [[nodiscard]] bool IsEmpty() const {
+      return size == 0;
+    }
+
+    [[nodiscard]] size_t GetSize() const {
+      return size;
+    }
+  };
+}
@@ -0,0 +1,51 @@
+#include "WorkerPool.hpp"
+
+namespace Ship {
+  WorkerPool::WorkerPool(size_t thread_count) {
+    workers.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+      workers.emplace_back(&WorkerPool::RunWorker, this);
+    }
+  }
+
+  WorkerPool::~WorkerPool() {
+    jobsMutex.lock();
+    stopping = true;
+    jobsMutex.unlock();
+    jobsCondition.notify_all();
+
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  void WorkerPool::Submit(std::function<void()> job) {
+    jobsMutex.lock();
+    jobs.push(std::move(job));
+    jobsMutex.unlock();
+    jobsCondition.notify_one();
+  }
+
+  size_t WorkerPool::GetThreadCount() const {
+    return workers.size();
+  }
+
+  void WorkerPool::RunWorker() {
+    while (true) {
+      std::unique_lock<std::mutex> lock(jobsMutex);
+      jobsCondition.wait(lock, [this]() {
+        return stopping || !jobs.empty();
+      });
+
+      if (jobs.empty()) {
+        return;
+      }
+
+      std::function<void()> job = std::move(jobs.front());
+      jobs.pop();
+      lock.unlock();
+
+      job();
+    }
+  }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Ship {
+  class WorkerPool {
+   private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> jobs;
+    std::mutex jobsMutex;
+    std::condition_variable jobsCondition;
+    bool stopping = false;
+
+    void RunWorker();
+
+   public:
+    explicit WorkerPool(size_t thread_count);
+    ~WorkerPool();
+
+    void Submit(std::function<void()> job);
+    [[nodiscard]] size_t GetThreadCount() const;
+  };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace Ship {
+  // Minimal timing harness for the benchmarks in this directory, every bench is a plain executable without external dependencies.
+  class Bench {
+   public:
+    // Keeps the compiler from dropping a computation whose result is otherwise unused.
+    template<typename T>
+    static void KeepAlive(const T& value) {
+      asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Runs the body once to warm caches, then returns the best nanoseconds per iteration out of a few rounds.
+    template<typename Body>
+    static double NanosPerIteration(size_t iterations, Body body) {
+      body();
+      double best = 0;
+      for (int round = 0; round < 5; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+          body();
+        }
+
+        double nanos = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        if (round == 0 || nanos < best) {
+          best = nanos;
+        }
+      }
+
+      return best / (double) iterations;
+    }
+
+    static void Report(const char* name, double nanos_per_iteration) {
+      std::printf("%-48s %10.2f ns/op\n", name, nanos_per_iteration);
+    }
+
+    // Benchmarks that guard a property, not only a timing, fail the run through this.
+    static void Require(bool condition, const char* message) {
+      if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", message);
+        std::exit(1);
+      }
+    }
+  };
+}
@@ -0,0 +1,236 @@
+#include "Bench.hpp"
+#include "ShipNet/protocol/packet/FieldPacket.hpp"
+#include <string>
+#include <vector>
+
+using namespace Ship;
+
+// Fixed-width fields only, their reads share one bounds check.
+class FieldPositionPacket : public FieldPacket<FieldPositionPacket> {
+ public:
+  uint64_t entityId = 0;
+  double x = 0;
+  double y = 0;
+  double z = 0;
+  float yaw = 0;
+  bool onGround = false;
+  UUID uuid;
+
+  using PacketFields = FieldList<PacketField<&FieldPositionPacket::entityId, LongField>, PacketField<&FieldPositionPacket::x, DoubleField>,
+    PacketField<&FieldPositionPacket::y, DoubleField>, PacketField<&FieldPositionPacket::z, DoubleField>,
+    PacketField<&FieldPositionPacket::yaw, FloatField>, PacketField<&FieldPositionPacket::onGround, BooleanField>,
+    PacketField<&FieldPositionPacket::uuid, UUIDField>>;
+
+  [[nodiscard]] uint32_t GetOrdinal() const override {
+    return 0;
+  }
+};
+
+// The same packet the way it is written without descriptors, every field is read through its own checked ByteBuffer call.
+class ManualPositionPacket : public Packet {
+ public:
+  uint64_t entityId = 0;
+  double x = 0;
+  double y = 0;
+  double z = 0;
+  float yaw = 0;
+  bool onGround = false;
+  UUID uuid;
+
+  Errorable<bool> Write(const ProtocolVersion* version, ByteBuffer* buffer) const override {
+    buffer->WriteLong(entityId);
+    buffer->WriteDouble(x);
+    buffer->WriteDouble(y);
+    buffer->WriteDouble(z);
+    buffer->WriteFloat(yaw);
+    buffer->WriteBoolean(onGround);
+    buffer->WriteUUID(uuid);
+    return SuccessErrorable<bool>(true);
+  }
+
+  uint32_t Size(const ProtocolVersion* version) const override {
+    return ByteBuffer::LONG_SIZE + ByteBuffer::DOUBLE_SIZE * 3 + ByteBuffer::FLOAT_SIZE + ByteBuffer::BOOLEAN_SIZE + ByteBuffer::UUID_SIZE;
+  }
+
+  [[nodiscard]] uint32_t GetOrdinal() const override {
+    return 0;
+  }
+
+  static Errorable<ManualPositionPacket> Instantiate(const PacketHolder& holder) {
+    ByteBuffer* buffer = holder.GetCurrentBuffer();
+    ManualPositionPacket packet;
+    ProceedErrorable(entityId, uint64_t, buffer->ReadLong(), InvalidPacketErrorable<ManualPositionPacket>(holder.GetOrdinal()))
+    ProceedErrorable(x, double, buffer->ReadDouble(), InvalidPacketErrorable<ManualPositionPacket>(holder.GetOrdinal()))
+    ProceedErrorable(y, double, buffer->ReadDouble(), InvalidPacketErrorable<ManualPositionPacket>(holder.GetOrdinal()))
+    ProceedErrorable(z, double, buffer->ReadDouble(), InvalidPacketErrorable<ManualPositionPacket>(holder.GetOrdinal()))
+    ProceedErrorable(yaw, float, buffer->ReadFloat(), InvalidPacketErrorable<ManualPositionPacket>(holder.GetOrdinal()))
+    ProceedErrorable(onGround, bool, buffer->ReadBoolean(), InvalidPacketErrorable<ManualPositionPacket>(holder.GetOrdinal()))
+    ProceedErrorable(uuid, UUID, buffer->ReadUUID(), InvalidPacketErrorable<ManualPositionPacket>(holder.GetOrdinal()))
+    packet.entityId = entityId;
+    packet.x = x;
+    packet.y = y;
+    packet.z = z;
+    packet.yaw = yaw;
+    packet.onGround = onGround;
+    packet.uuid = uuid;
+    return SuccessErrorable<ManualPositionPacket>(packet);
+  }
+};
+
+// Mixes fixed and variable fields with limits.
+class FieldChatPacket : public FieldPacket<FieldChatPacket> {
+ public:
+  uint32_t sender = 0;
+  std::string message;
+  std::optional<uint32_t> replyTo;
+  std::vector<uint32_t> mentions;
+
+  using PacketFields = FieldList<PacketField<&FieldChatPacket::sender, IntField>, PacketField<&FieldChatPacket::message, StringField<256>>,
+    PacketField<&FieldChatPacket::replyTo, OptionalField<VarIntField>>, PacketField<&FieldChatPacket::mentions, ArrayField<IntField, 16>>>;
+
+  [[nodiscard]] uint32_t GetOrdinal() const override {
+    return 1;
+  }
+};
+
+class ManualChatPacket : public Packet {
+ public:
+  uint32_t sender = 0;
+  std::string message;
+  std::optional<uint32_t> replyTo;
+  std::vector<uint32_t> mentions;
+
+  Errorable<bool> Write(const ProtocolVersion* version, ByteBuffer* buffer) const override {
+    buffer->WriteInt(sender);
+    ProceedErrorable(written, bool, buffer->WriteString(message, 256), InvalidPacketErrorable<bool>(GetOrdinal()))
+    buffer->WriteBoolean(replyTo.has_value());
+    if (replyTo) {
+      buffer->WriteVarInt(*replyTo);
+    }
+
+    if (mentions.size() > 16) {
+      return InvalidPacketErrorable<bool>(GetOrdinal());
+    }
+
+    buffer->WriteVarInt(mentions.size());
+    for (uint32_t mention : mentions) {
+      buffer->WriteInt(mention);
+    }
+
+    return SuccessErrorable<bool>(written);
+  }
+
+  uint32_t Size(const ProtocolVersion* version) const override {
+    return ByteBuffer::INT_SIZE + ByteBuffer::StringBytes(message) + ByteBuffer::BOOLEAN_SIZE + (replyTo ? ByteBuffer::VarIntBytes(*replyTo) : 0)
+      + ByteBuffer::VarIntBytes(mentions.size()) + mentions.size() * ByteBuffer::INT_SIZE;
+  }
+
+  [[nodiscard]] uint32_t GetOrdinal() const override {
+    return 1;
+  }
+
+  static Errorable<ManualChatPacket> Instantiate(const PacketHolder& holder) {
+    ByteBuffer* buffer = holder.GetCurrentBuffer();
+    ManualChatPacket packet;
+    ProceedErrorable(sender, uint32_t, buffer->ReadInt(), InvalidPacketErrorable<ManualChatPacket>(holder.GetOrdinal()))
+    ProceedErrorable(message, std::string, buffer->ReadString(256), InvalidPacketErrorable<ManualChatPacket>(holder.GetOrdinal()))
+    ProceedErrorable(hasReply, bool, buffer->ReadBoolean(), InvalidPacketErrorable<ManualChatPacket>(holder.GetOrdinal()))
+    if (hasReply) {
+      ProceedErrorable(replyTo, uint32_t, buffer->ReadVarInt(), InvalidPacketErrorable<ManualChatPacket>(holder.GetOrdinal()))
+      packet.replyTo = replyTo;
+    }
+
+    ProceedErrorable(length, uint32_t, buffer->ReadVarInt(), InvalidPacketErrorable<ManualChatPacket>(holder.GetOrdinal()))
+    if (length > 16) {
+      return InvalidPacketErrorable<ManualChatPacket>(holder.GetOrdinal());
+    }
+
+    packet.mentions.reserve(length);
+    for (uint32_t i = 0; i < length; ++i) {
+      ProceedErrorable(mention, uint32_t, buffer->ReadInt(), InvalidPacketErrorable<ManualChatPacket>(holder.GetOrdinal()))
+      packet.mentions.push_back(mention);
+    }
+
+    packet.sender = sender;
+    packet.message = message;
+    return SuccessErrorable<ManualChatPacket>(packet);
+  }
+};
+
+template<typename P>
+static void FillPosition(P& packet) {
+  packet.entityId = 0x0123456789ABCDEFULL;
+  packet.x = 128.5;
+  packet.y = 64.0;
+  packet.z = -256.25;
+  packet.yaw = 90.0F;
+  packet.onGround = true;
+  packet.uuid = UUID(0x1122334455667788ULL, 0x99AABBCCDDEEFF00ULL);
+}
+
+template<typename P>
+static void FillChat(P& packet) {
+  packet.sender = 42;
+  packet.message = "anyone up for a match on the east server? meet at spawn";
+  packet.replyTo = 1337;
+  packet.mentions = {7, 8, 9, 10};
+}
+
+// Writes the packet and decodes it again from the same buffer, so both directions are covered by one iteration.
+// The drained segment goes back to the pool each time, like a connection buffer between packets.
+template<typename P>
+static double RoundTrip(const P& packet, ByteBuffer* buffer) {
+  return Bench::NanosPerIteration(200000, [&] {
+    Bench::KeepAlive(packet.Write(nullptr, buffer).IsSuccess());
+    Errorable<P> decoded = P::Instantiate(PacketHolder(packet.GetOrdinal(), nullptr, buffer, packet.Size(nullptr)));
+    Bench::KeepAlive(decoded.IsSuccess());
+    buffer->ReleaseIfDrained();
+  });
+}
+
+int main() {
+  ByteBufferImpl buffer(4096);
+
+  FieldPositionPacket fieldPosition;
+  ManualPositionPacket manualPosition;
+  FillPosition(fieldPosition);
+  FillPosition(manualPosition);
+  fieldPosition.Write(nullptr, &buffer);
+  ManualPositionPacket decodedPosition = ManualPositionPacket::Instantiate(PacketHolder(0, nullptr, &buffer, 0)).GetValue();
+  Bench::Require(decodedPosition.entityId == fieldPosition.entityId && decodedPosition.z == fieldPosition.z
+      && decodedPosition.uuid == fieldPosition.uuid && fieldPosition.Size(nullptr) == manualPosition.Size(nullptr),
+    "field and manual position packets share their encoding");
+
+  FieldChatPacket fieldChat;
+  ManualChatPacket manualChat;
+  FillChat(fieldChat);
+  FillChat(manualChat);
+  manualChat.Write(nullptr, &buffer);
+  FieldChatPacket decodedChat = FieldChatPacket::Instantiate(PacketHolder(1, nullptr, &buffer, 0)).GetValue();
+  Bench::Require(decodedChat.message == manualChat.message && decodedChat.replyTo == manualChat.replyTo && decodedChat.mentions == manualChat.mentions
+      && fieldChat.Size(nullptr) == manualChat.Size(nullptr), "field and manual chat packets share their encoding");
+
+  // Limits are enforced on write as well, so nothing is sent that the other side would reject.
+  fieldChat.mentions.resize(17);
+  Bench::Require(!fieldChat.Write(nullptr, &buffer).IsSuccess(), "arrays above MaxLength are refused on write");
+  fieldChat.mentions.resize(4);
+  fieldChat.message = std::string(257, 'x');
+  Bench::Require(!fieldChat.Write(nullptr, &buffer).IsSuccess(), "strings above MaxSize are refused on write");
+  FillChat(fieldChat);
+  buffer.Release();
+
+  Bench::Report("FieldPacket position round trip", RoundTrip(fieldPosition, &buffer));
+  Bench::Report("manual position round trip", RoundTrip(manualPosition, &buffer));
+  Bench::Report("FieldPacket chat round trip", RoundTrip(fieldChat, &buffer));
+  Bench::Report("manual chat round trip", RoundTrip(manualChat, &buffer));
+
+  Bench::Report("FieldPacket chat Size", Bench::NanosPerIteration(1000000, [&] {
+    Bench::KeepAlive(fieldChat.Size(nullptr));
+  }));
+
+  Bench::Report("manual chat Size", Bench::NanosPerIteration(1000000, [&] {
+    Bench::KeepAlive(manualChat.Size(nullptr));
+  }));
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include "Bench.hpp"
+#include "ShipNet/protocol/registry/FrozenVersionedRegistry.hpp"
+#include <list>
+#include <random>
+
+using namespace Ship;
+
+// Compares id/ordinal lookups of a compacted VersionedRegistry, where later versions are deltas, with the flat frozen tables.
+int main() {
+  const uint32_t versionCount = 16;
+  const uint32_t packetCount = 128;
+  const size_t lookupCount = 4096;
+
+  std::list<ProtocolVersion> versionList;
+  for (uint32_t i = 0; i < versionCount; ++i) {
+    versionList.emplace_back(i, 100 + i * 10, "v" + std::to_string(i));
+  }
+
+  ProtocolVersions versions(versionList);
+  std::set<ProtocolVersion> versionMap(versionList.begin(), versionList.end());
+  VersionedRegistry registry(versions, versionMap);
+
+  // Every version moves a few packets around, like protocol updates usually do.
+  std::mt19937 random(42);
+  std::vector<uint32_t> ordinals(packetCount);
+  for (uint32_t i = 0; i < packetCount; ++i) {
+    ordinals[i] = i;
+  }
+
+  for (const ProtocolVersion& version : versionList) {
+    for (int swap = 0; swap < 4; ++swap) {
+      std::swap(ordinals[random() % packetCount], ordinals[random() % packetCount]);
+    }
+
+    registry.RegisterVersion(&version, new VersionRegistry(ordinals));
+  }
+
+  registry.Compact();
+  FrozenVersionedRegistry frozen(registry);
+
+  std::vector<const ProtocolVersion*> lookupVersions(lookupCount);
+  std::vector<uint32_t> lookupKeys(lookupCount);
+  for (size_t i = 0; i < lookupCount; ++i) {
+    lookupVersions[i] = versions.FromOrdinal(random() % versionCount);
+    lookupKeys[i] = random() % packetCount;
+  }
+
+  Bench::Report("VersionedRegistry::GetOrdinalByID", Bench::NanosPerIteration(1000, [&] {
+    for (size_t i = 0; i < lookupCount; ++i) {
+      Bench::KeepAlive(registry.GetOrdinalByID(lookupVersions[i], lookupKeys[i]).GetValue());
+    }
+  }) / lookupCount);
+
+  Bench::Report("FrozenVersionedRegistry::GetOrdinalByID", Bench::NanosPerIteration(1000, [&] {
+    for (size_t i = 0; i < lookupCount; ++i) {
+      Bench::KeepAlive(frozen.GetOrdinalByID(lookupVersions[i], lookupKeys[i]));
+    }
+  }) / lookupCount);
+
+  Bench::Report("VersionedRegistry::GetIDByOrdinal", Bench::NanosPerIteration(1000, [&] {
+    for (size_t i = 0; i < lookupCount; ++i) {
+      Bench::KeepAlive(registry.GetIDByOrdinal(lookupVersions[i], lookupKeys[i]).GetValue());
+    }
+  }) / lookupCount);
+
+  Bench::Report("FrozenVersionedRegistry::GetIDByOrdinal", Bench::NanosPerIteration(1000, [&] {
+    for (size_t i = 0; i < lookupCount; ++i) {
+      Bench::KeepAlive(frozen.GetIDByOrdinal(lookupVersions[i], lookupKeys[i]));
+    }
+  }) / lookupCount);
+
+  for (size_t i = 0; i < lookupCount; ++i) {
+    Bench::Require(frozen.GetOrdinalByID(lookupVersions[i], lookupKeys[i])
+        == registry.GetOrdinalByID(lookupVersions[i], lookupKeys[i]).GetValue(), "frozen lookups match the registry");
+  }
+
+  std::printf("frozen tables: %zu bytes\n", frozen.GetTableBytes());
+  return 0;
+}
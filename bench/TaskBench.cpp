@@ -0,0 +1,64 @@
+#include "Bench.hpp"
+#include "ShipNet/utils/thread/EventLoop.hpp"
+#include <memory>
+#include <string>
+
+using namespace Ship;
+
+class Tick {
+ public:
+  EventLoop* loop;
+  uint64_t* ticks;
+
+  void operator()() const {
+    ++*ticks;
+    loop->Delay(*this, 0);
+  }
+};
+
+// Posting and delaying tasks must not allocate once the task rings and the delay heap reached their working size.
+int main() {
+  EventLoop loop;
+  auto payload = std::make_shared<const std::string>(64, 'x');
+  uint64_t written = 0;
+
+  // Shaped like a write handed to the owning loop: the loop, a connection handle and a shared payload.
+  auto postWrite = [&](uint64_t handle) {
+    loop.Post([loop = &loop, handle, payload, &written]() {
+      written += handle != 0 && loop ? payload->size() : 0;
+    });
+  };
+
+  for (int warmup = 0; warmup < 4; ++warmup) {
+    for (uint64_t handle = 1; handle <= 256; ++handle) {
+      postWrite(handle);
+    }
+
+    loop.ProceedTasks();
+  }
+
+  uint64_t allocations = Task::GetAllocationCount();
+  Bench::Report("EventLoop::Post write task", Bench::NanosPerIteration(1000, [&] {
+    for (uint64_t handle = 1; handle <= 256; ++handle) {
+      postWrite(handle);
+    }
+
+    loop.ProceedTasks();
+  }) / 256);
+  Bench::Require(Task::GetAllocationCount() == allocations, "posting warm write tasks doesn't allocate");
+
+  // A tick that delays itself by 0 ms runs once per ProceedTasks instead of spinning inside it.
+  uint64_t ticks = 0;
+  loop.Delay(Tick {&loop, &ticks}, 0);
+  loop.ProceedTasks();
+  allocations = Task::GetAllocationCount();
+  uint64_t ticksBefore = ticks;
+  Bench::Report("EventLoop::Delay 0 ms tick", Bench::NanosPerIteration(100000, [&] {
+    loop.ProceedTasks();
+  }));
+  Bench::Require(ticks - ticksBefore == 5 * 100000 + 1, "a self delaying task runs once per ProceedTasks");
+  Bench::Require(Task::GetAllocationCount() == allocations, "re-delaying a warm tick doesn't allocate");
+
+  Bench::KeepAlive(written);
+  return 0;
+}
@@ -0,0 +1,80 @@
+#include "Bench.hpp"
+#include "ShipNet/protocol/data/uuid/UUID.hpp"
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace Ship;
+
+// strtoull/snprintf reference the table based parser and formatter are compared with.
+static UUID ReferenceParse(const std::string& uuid) {
+  std::string undashed;
+  for (char character : uuid) {
+    if (character != '-') {
+      undashed += character;
+    }
+  }
+
+  return {std::strtoull(undashed.substr(0, 16).c_str(), nullptr, 16), std::strtoull(undashed.substr(16).c_str(), nullptr, 16)};
+}
+
+static std::string ReferenceFormat(const UUID& uuid) {
+  char output[UUID::STRING_SIZE + 1];
+  uint64_t most = uuid.GetMostSignificant();
+  uint64_t least = uuid.GetLeastSignificant();
+  std::snprintf(output, sizeof(output), "%08x-%04x-%04x-%04x-%012llx", (unsigned) (most >> 32), (unsigned) (most >> 16 & 0xFFFF),
+    (unsigned) (most & 0xFFFF), (unsigned) (least >> 48), (unsigned long long) (least & 0xFFFFFFFFFFFFULL));
+  return output;
+}
+
+int main() {
+  const size_t uuidCount = 1024;
+  std::vector<UUID> uuids;
+  std::vector<std::string> dashed;
+  std::vector<std::string> undashed;
+  uint64_t state = 0x243F6A8885A308D3ULL;
+  for (size_t i = 0; i < uuidCount; ++i) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint64_t most = state;
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    uuids.emplace_back(most, state);
+    dashed.push_back(uuids.back().ToString());
+    undashed.push_back(uuids.back().ToUndashedString());
+    Bench::Require(UUID::Instantiate(dashed.back()).GetValue() == uuids.back() && ReferenceParse(dashed.back()) == uuids.back()
+        && ReferenceFormat(uuids.back()) == dashed.back(), "UUIDs round trip through both implementations");
+  }
+
+  size_t next = 0;
+  Bench::Report("UUID::Instantiate dashed", Bench::NanosPerIteration(1000000, [&] {
+    Bench::KeepAlive(UUID::Instantiate(dashed[next++ % uuidCount]).GetValue());
+  }));
+
+  Bench::Report("UUID::Instantiate undashed", Bench::NanosPerIteration(1000000, [&] {
+    Bench::KeepAlive(UUID::Instantiate(undashed[next++ % uuidCount]).GetValue());
+  }));
+
+  Bench::Report("reference strtoull parse", Bench::NanosPerIteration(1000000, [&] {
+    Bench::KeepAlive(ReferenceParse(dashed[next++ % uuidCount]));
+  }));
+
+  char output[UUID::STRING_SIZE];
+  Bench::Report("UUID::WriteString", Bench::NanosPerIteration(1000000, [&] {
+    uuids[next++ % uuidCount].WriteString(output);
+    Bench::KeepAlive(output);
+  }));
+
+  Bench::Report("UUID::ToString", Bench::NanosPerIteration(1000000, [&] {
+    Bench::KeepAlive(uuids[next++ % uuidCount].ToString());
+  }));
+
+  Bench::Report("reference snprintf format", Bench::NanosPerIteration(1000000, [&] {
+    Bench::KeepAlive(ReferenceFormat(uuids[next++ % uuidCount]));
+  }));
+
+  std::unordered_set<UUID> set(uuids.begin(), uuids.end());
+  Bench::Report("std::unordered_set<UUID>::count", Bench::NanosPerIteration(1000000, [&] {
+    Bench::KeepAlive(set.count(uuids[next++ % uuidCount]));
+  }));
+
+  return 0;
+}
@@ -0,0 +1,54 @@
+#include "Bench.hpp"
+#include "ShipNet/utils/text/Utf8.hpp"
+#include <string>
+
+using namespace Ship;
+
+// Compares the block validator with the byte-at-a-time reference on typical protocol strings and non-Latin text.
+int main() {
+  std::string chat;
+  while (chat.size() < 256) {
+    chat += "<Player> hello there, anyone up for a match? ";
+  }
+
+  std::string mixed;
+  while (mixed.size() < 256) {
+    mixed += "Grüße aus Köln, привет, 你好 ";
+  }
+
+  std::string cyrillic;
+  while (cyrillic.size() < 4096) {
+    cyrillic += "Добро пожаловать на сервер, удачной игры! ";
+  }
+
+  std::string cjk;
+  while (cjk.size() < 4096) {
+    cjk += "欢迎来到服务器，祝你玩得开心！😀";
+  }
+
+  std::string json;
+  while (json.size() < 32768) {
+    json += R"({"text":"Welcome to the server","color":"gold","bold":true},)";
+  }
+
+  const std::pair<const char*, const std::string*> inputs[] = {{"ascii 256 B", &chat}, {"mixed 256 B", &mixed}, {"cyrillic 4 KiB", &cyrillic},
+    {"cjk 4 KiB", &cjk}, {"ascii 32 KiB", &json}};
+  for (const auto& input : inputs) {
+    const auto* bytes = (const uint8_t*) input.second->data();
+    size_t size = input.second->size();
+    Bench::Require(Utf8::CountUtf16Units(bytes, size).GetValue() == Utf8::CountUtf16UnitsScalar(bytes, size).GetValue(),
+      "both validators count the same units");
+
+    std::string name = std::string("Utf8::CountUtf16Units ") + input.first;
+    Bench::Report(name.c_str(), Bench::NanosPerIteration(20000, [&] {
+      Bench::KeepAlive(Utf8::CountUtf16Units(bytes, size).GetValue());
+    }));
+
+    name = std::string("Utf8::CountUtf16UnitsScalar ") + input.first;
+    Bench::Report(name.c_str(), Bench::NanosPerIteration(20000, [&] {
+      Bench::KeepAlive(Utf8::CountUtf16UnitsScalar(bytes, size).GetValue());
+    }));
+  }
+
+  return 0;
+}